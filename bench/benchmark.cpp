@@ -0,0 +1,300 @@
+// Micro-benchmarks for the core engine routines
+// Runs on SDL's dummy video driver with a software renderer, so it needs no display
+// Run from the project root so the graphics/ paths resolve
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <string>
+#include <vector>
+#include <iostream>
+#define SDL_MAIN_HANDLED  // Plain main, SDL doesn't need to wrap it here
+#include <SDL2/SDL.h>
+#include "../include/engine.h"
+#include "../include/settings.h"
+#include "../include/types.h"
+#include "../include/sprite.h"
+#include "../include/ecs.h"
+#include "../include/systems.h"
+#include "../include/render.h"
+#include "../include/jobs.h"
+#include "../include/swarm.h"
+#include "../include/projectiles.h"
+#include "../include/effects.h"
+#include "../include/background.h"
+#include "../include/collide.h"
+#include "../include/resources.h"
+#include "../include/archive.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+  #ifdef _MSC_VER
+    #include <intrin.h>
+  #else
+    #include <x86intrin.h>
+  #endif
+  #define BENCH_HAS_TSC
+#endif
+
+// Game globals the engine sources expect main.cpp to provide
+int playerScore = 0;
+int playerLives = 3;
+World* world = NULL;
+
+// Count every allocation made through operator new
+static std::size_t allocations = 0;
+
+void* operator new(std::size_t size) {
+  allocations++;
+  if(void* memory = std::malloc(size ? size : 1))
+    return memory;
+  throw std::bad_alloc();
+}
+void operator delete(void* memory) noexcept { std::free(memory); }
+void operator delete(void* memory, std::size_t) noexcept { std::free(memory); }
+
+namespace {
+  const double MIN_SECONDS = 0.2;   // Keep running each benchmark for at least this long
+
+  Uint64 cycles() {
+#ifdef BENCH_HAS_TSC
+    return __rdtsc();
+#else
+    return 0;
+#endif
+  }
+
+  // Print one result row
+  void report(const char* name, int param, double seconds, Uint64 cycleCount, std::size_t allocs, long long ops) {
+    std::printf("%-46s %8d %12.1f", name, param, seconds * 1e9 / ops);
+#ifdef BENCH_HAS_TSC
+    std::printf(" %12.0f", static_cast<double>(cycleCount) / ops);
+#else
+    std::printf(" %12s", "-");
+#endif
+    std::printf(" %10.2f\n", static_cast<double>(allocs) / ops);
+  }
+
+  // Time body in growing batches until the minimum time has passed
+  // For routines cheap enough that per-call timing would swamp them
+  template <typename Body>
+  void measure(const char* name, int param, Body body) {
+    body();   // Warm up caches and any lazy setup
+    long long ops = 0;
+    long long batchSize = 1;
+    double seconds = 0;
+    Uint64 cycleCount = 0;
+    std::size_t allocs = 0;
+    const double frequency = static_cast<double>(SDL_GetPerformanceFrequency());
+    while(seconds < MIN_SECONDS) {
+      std::size_t allocStart = allocations;
+      Uint64 cycleStart = cycles();
+      Uint64 start = SDL_GetPerformanceCounter();
+      for(long long i = 0; i < batchSize; ++i)
+        body();
+      seconds += (SDL_GetPerformanceCounter() - start) / frequency;
+      cycleCount += cycles() - cycleStart;
+      allocs += allocations - allocStart;
+      ops += batchSize;
+      batchSize *= 2;
+    }
+    report(name, param, seconds, cycleCount, allocs, ops);
+  }
+
+  // Time body one call at a time, running the untimed setup before each call
+  // For routines that use up the state they work on
+  template <typename Setup, typename Body>
+  void measure(const char* name, int param, Setup setup, Body body) {
+    setup();
+    body();
+    long long ops = 0;
+    double seconds = 0;
+    Uint64 cycleCount = 0;
+    std::size_t allocs = 0;
+    const double frequency = static_cast<double>(SDL_GetPerformanceFrequency());
+    while(seconds < MIN_SECONDS) {
+      setup();
+      std::size_t allocStart = allocations;
+      Uint64 cycleStart = cycles();
+      Uint64 start = SDL_GetPerformanceCounter();
+      body();
+      seconds += (SDL_GetPerformanceCounter() - start) / frequency;
+      cycleCount += cycles() - cycleStart;
+      allocs += allocations - allocStart;
+      ops++;
+    }
+    report(name, param, seconds, cycleCount, allocs, ops);
+  }
+
+  // Stop the optimizer dropping results nothing reads
+  volatile int sink = 0;
+
+  // Headless build boxes have no display, so use the dummy video driver and draw into a plain surface
+  SDL_Surface* screen = NULL;
+
+  bool init() {
+    SDL_SetHint(SDL_HINT_VIDEODRIVER, "dummy");
+    SDL_SetMainReady();
+    if(SDL_Init(SDL_INIT_VIDEO | SDL_INIT_TIMER) < 0) {
+      std::cout << "SDL could not initialize! SDL_Error: " << SDL_GetError() << '\n';
+      return false;
+    }
+    screen = SDL_CreateRGBSurfaceWithFormat(0, settings::SCREEN_WIDTH, settings::SCREEN_HEIGHT, 32, SDL_PIXELFORMAT_ARGB8888);
+    SDL::renderer = screen ? SDL_CreateSoftwareRenderer(screen) : NULL;
+    if(SDL::renderer == NULL) {
+      std::cout << "Software renderer could not be created! SDL_Error: " << SDL_GetError() << '\n';
+      return false;
+    }
+    if(!AlienSwarm::init() || !ProjectilePool::init() || !Effects::init())
+      return false;
+    SDL::static_init = true;
+    return true;
+  }
+
+  void shutdown() {
+    Effects::destroy();
+    Sprites::release();
+    alienTextureSheet.reset();
+    bulletTextureSheet.reset();
+    Resources::shutdown();
+    SDL_DestroyRenderer(SDL::renderer);
+    SDL_FreeSurface(screen);
+    SDL_Quit();
+  }
+}
+
+int main() {
+  if(!init())
+    return 1;
+  world = new World();
+
+  std::printf("%-46s %8s %12s %12s %10s\n", "benchmark", "n", "ns/op", "cycles/op", "allocs/op");
+
+  measure("hexToRGB", 1, [] {
+    sink = sink + hexToRGB("#ff8000").g;
+  });
+
+  // Entity churn, one effect spawned and destroyed
+  {
+    World entities;
+    measure("World::create+destroy", 1, [&] {
+      entities.destroy(Effects::spawn(entities, EffectType::explosion, { 100, 100 }));
+    });
+  }
+
+  // Systems over growing numbers of animated sprites
+  for(int count : { 64, 4096, 65536 }) {
+    World entities;
+    const Sprite sprite = Sprites::load("graphics/sprite.bmp", 16, "#000000");
+    for(int i = 0; i < count; ++i) {
+      Entity entity = entities.create<Transform, Sprite, Animation>();
+      entities.get<Transform>(entity)->position = { std::rand() % settings::SCREEN_WIDTH, std::rand() % settings::SCREEN_HEIGHT };
+      *entities.get<Sprite>(entity) = sprite;
+      entities.get<Animation>(entity)->frames = 16;
+      entities.get<Animation>(entity)->frameDelay = 2;
+    }
+    measure("Systems::animate", count, [&] {
+      Systems::animate(entities);
+    });
+    Render::Frame frame;
+    measure("Systems::render", count, [&] {
+      frame.clear();
+      Systems::render(entities, frame, Layer::actors, 0.5f);
+    });
+    measure("Render::draw", count, [&] {
+      Render::draw(frame);
+    });
+  }
+
+  // Batch kernel against growing sets of boxes
+  for(int count : { 64, 1024, 16384 }) {
+    std::vector<int> x(count), y(count);
+    std::vector<std::uint64_t> hits(Collide::maskWords(count));
+    for(int i = 0; i < count; ++i) {
+      x[i] = std::rand() % settings::SCREEN_WIDTH;
+      y[i] = std::rand() % settings::SCREEN_HEIGHT;
+    }
+    const SDL_Rect box = { 800, 450, 12, 30 };
+    const std::string label = std::string("Collide::overlaps (") + Collide::kernelName() + ")";
+    measure(label.c_str(), count, [&] {
+      sink = sink + Collide::overlaps(box, x.data(), y.data(), 100, 48, count, hits.data());
+    });
+  }
+
+  // Swarm updates and collision checks split across threads, run them on one thread and then on every core
+  std::vector<int> threadCounts = { 1 };
+  if(SDL_GetCPUCount() > 1)
+    threadCounts.push_back(SDL_GetCPUCount());
+  for(int threads : threadCounts) {
+    Jobs::init(threads);
+    const std::string suffix = " (" + std::to_string(threads) + (threads == 1 ? " thread)" : " threads)");
+
+    // Swarm sizes from the stock wave up to a bullet hell
+    const int swarmSizes[][2] = { { 4, 10 }, { 20, 50 }, { 40, 250 }, { 200, 500 } };
+    for(const auto& size : swarmSizes) {
+      AlienSwarm swarm(size[0], size[1], 1);
+      int ticks = 0;
+      measure(("AlienSwarm::update" + suffix).c_str(), size[0] * size[1], [&] {
+        swarm.update();
+        if(++ticks % 500 == 0)  // Keep the swarm on screen
+          swarm.resetLocation();
+      });
+    }
+
+    // Every shot in flight checked against the full stock wave
+    for(int shots : { 5, 500, 5000 }) {
+      AlienSwarm swarm(settings::swarmRows, settings::swarmColumns, 1);
+      ProjectilePool pool(shots);
+      measure(("ProjectilePool::checkCollisions" + suffix).c_str(), shots,
+        [&] {   // Fresh wave with a fresh volley spread across the screen
+          swarm.resetRound(1);
+          pool.clear();
+          Effects::clear(*world);
+          std::srand(shots);
+          for(int i = 0; i < shots; ++i)
+            pool.acquire(Owner::player, { std::rand() % settings::SCREEN_WIDTH, std::rand() % 400 }, 0, -15);
+        },
+        [&] {
+          sink = sink + pool.checkCollisions(swarm);
+        });
+    }
+  }
+  Jobs::shutdown();
+
+  // Opening the cooked archive and decoding a loose bitmap, the two ways an image reaches the loader
+  measure("Archive::open", 1, [] {
+    Archive::open("graphics/assets.pak");
+    Archive::close();
+  });
+  measure("SDL::loadImage (bg.bmp)", 1, [] {
+    SDL_FreeSurface(SDL::loadImage("graphics/bg.bmp"));
+  });
+
+  // Map load, then baking and drawing against the software renderer
+  measure("Tilemap::Tilemap", 1, [] {
+    Tilemap map("graphics/map.tmb");
+  });
+  {
+    Tilemap map("graphics/map.tmb");
+    Render::Frame frame;
+    map.prepare();
+    measure("Tilemap::draw", 1, [&] {
+      frame.clear();
+      map.prepare();
+      map.draw(frame);
+      Render::draw(frame);
+    });
+    int tile = 0;
+    measure("Tilemap::draw (one tile changed)", 1, [&] {
+      map.setTile(10, 10, tile++ % 8);
+      frame.clear();
+      map.prepare();
+      map.draw(frame);
+      Render::draw(frame);
+    });
+  }
+
+  delete world;
+  shutdown();
+  return 0;
+}
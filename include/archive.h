@@ -0,0 +1,22 @@
+#ifndef ARCHIVE_H
+#define ARCHIVE_H
+
+#include <SDL2/SDL.h>
+#include <string>
+#include "assetformat.h"
+#include "types.h"
+
+// Packed asset archive
+// The cooked .pak (see assetformat.h) is mapped once and used in place, images in it are already in the texture's format
+// Assets that aren't in the archive load from their loose files as before
+namespace Archive {
+  bool open(const std::string& path);   // Map an archive and check its index, false if it is missing or invalid
+  void close();   // Unmap the archive, nothing may still point into it
+  const assetformat::Entry* find(const std::string& name);  // Entry for an asset path or atlas page, NULL if it wasn't cooked
+  const assetformat::Entry* page(const assetformat::Entry& sheet);  // Image a sheet is packed onto
+  unsigned char* data(const assetformat::Entry& entry);   // First byte of an entry's data inside the mapping
+  bool matches(const assetformat::Entry& entry, const RGB* transparency);   // Was it cooked with this color key, or none if NULL?
+  SDL_Surface* surface(const assetformat::Entry& image);  // Surface over an image's pixels, no copy or conversion. Safe on any thread
+}
+
+#endif
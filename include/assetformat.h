@@ -0,0 +1,50 @@
+#ifndef ASSETFORMAT_H
+#define ASSETFORMAT_H
+
+#include <cstdint>
+
+// Packed asset archive (.pak), written by the assetcook tool
+// A fixed header, the data of every entry, then an index of entries at indexOffset
+// Images are stored as ARGB8888 rows with their color key already turned into alpha, ready to copy into a texture
+// All values are little-endian, the file is used in place straight from a memory mapping
+namespace assetformat {
+  const char MAGIC[4] = { 'A', 'P', 'A', 'K' };
+  const std::uint16_t VERSION = 1;
+  const std::uint32_t PIXEL_FORMAT = 0x16362004;  // SDL_PIXELFORMAT_ARGB8888, spelled out so the cooker doesn't need SDL
+  const std::uint32_t NO_TRANSPARENCY = 0xffffffff;   // Color key of an image drawn fully opaque
+  const std::uint32_t DATA_ALIGNMENT = 64;  // Every entry's data starts on a boundary this size
+
+  enum Kind : std::uint16_t {
+    IMAGE = 0,  // Pixels, drawn on their own or holding packed sheets (atlas pages)
+    SHEET = 1,  // Sprite sheet packed onto an IMAGE, no data of its own
+    BLOB = 2    // Any other file, stored as-is
+  };
+
+  struct Header {
+    char magic[4];    // Always MAGIC
+    std::uint16_t version;      // Format version, VERSION
+    std::uint16_t entryCount;   // Entries in the index
+    std::uint32_t pixelFormat;  // Format of every image, PIXEL_FORMAT
+    std::uint32_t indexOffset;  // Byte offset of the first entry from the start of the file
+  };
+  static_assert(sizeof(Header) == 16, "Asset archive header must stay packed");
+
+  struct Entry {
+    char name[48];    // Path the asset was cooked from, zero padded
+    std::uint16_t kind;     // One of Kind
+    std::uint16_t page;     // SHEET: index of the IMAGE entry it is packed onto
+    std::uint16_t x;        // SHEET: spot on the page
+    std::uint16_t y;
+    std::uint16_t width;    // IMAGE and SHEET: size in pixels
+    std::uint16_t height;
+    std::uint16_t frames;   // Frames along the strip, 1 for still images
+    std::uint16_t frameDelay;   // Ticks to hold each frame for
+    std::uint32_t transparency;   // Color key baked into alpha as 0xRRGGBB, NO_TRANSPARENCY if none
+    std::uint32_t offset;   // IMAGE and BLOB: byte offset of the data from the start of the file
+    std::uint32_t size;     // IMAGE and BLOB: bytes of data
+    std::uint32_t pitch;    // IMAGE: bytes per row
+  };
+  static_assert(sizeof(Entry) == 80, "Asset archive entry must stay packed");
+}
+
+#endif
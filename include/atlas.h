@@ -0,0 +1,32 @@
+#ifndef ATLAS_H
+#define ATLAS_H
+
+#include <SDL2/SDL.h>
+#include <string>
+#include <vector>
+#include "types.h"
+#include "resources.h"
+
+// Texture atlas
+// Packs sprite sheets onto a few large textures so sprites share texture binds
+// Pages come cooked from the asset archive when every sheet is in it, otherwise they are packed and composed at startup
+// Either way they are uploaded by the loader, a sheet can only be found once its page has arrived
+namespace Atlas {
+  // A sheet to pack
+  struct Sheet {
+    std::string path;   // Path to bitMap image
+    std::string transparency;   // Hex color to treat as transparent
+  };
+
+  // Where a packed sheet ended up
+  struct Region {
+    TextureHandle texture;  // Atlas page holding the sheet
+    SDL_Rect rect = { 0, 0, 0, 0 };   // Sub-rectangle of the page holding the sheet
+  };
+
+  bool build(const std::vector<Sheet>& sheets, std::string cachePath);  // Pack every sheet and queue the pages to load, reusing a cached layout if it is still valid
+  bool find(const std::string& path, const RGB& transparency, Region& region);  // Look up a packed sheet
+  void destroy();   // Free all atlas pages
+}
+
+#endif
@@ -4,37 +4,48 @@
 #include <SDL2/SDL.h>
 #include <string>
 #include <iostream>
+#include "resources.h"
+#include "mappedfile.h"
+#include "render.h"
 
 // Background object
 class Background {
   public:
     int scrollSpeed = 3;  // Speed at which BG scrolls in pixels
   private:
-    SDL_Texture* texture = NULL; // Hold the background texture
-    SDL_Rect rect;  // Render rectangle
+    TextureHandle texture; // Hold the background texture
     int yOffset = 0;  // Current y-offset for calculating scroll
+    int prevOffset = 0;   // Y-offset on the previous tick, for interpolation
     const std::string PATH; // Path to bitMap image
 
   public:
     Background(std::string filePath); // Constructor
-    ~Background();  // Destructor
+    ~Background() = default;  // Destructor
 
     // Override Operator<<
     friend std::ostream& operator<<(std::ostream& out, const Background& background);
 
   public:
     void scroll();  // Scroll the background by one tick
-    void draw();  // Draw the background to the render
+    void draw(Render::Frame& frame, float alpha = 1.0f);  // Add the background to the frame, interpolated between ticks
 };
 
 // Tilemap object
+// Tile data is used in place from a memory mapped .tmb file (see mapformat.h), or its copy in the asset archive
+// Tiles are composited once onto a layer texture, which is drawn with a single copy
+// Baking draws straight to the renderer, so prepare() and setTile() belong to the render thread
 class Tilemap {
   private:
-    SDL_Texture* texture = NULL;
-    SDL_Rect rectSource;
-    SDL_Rect rectPlacement;
+    TextureHandle texture;
+    TextureHandle layer;    // Pre-baked tiles, empty if render targets aren't supported
+    SDL_Rect rectLayer;       // Screen area covered by the whole map
+    SDL_Rect dirty;           // Region of the layer that needs baking again
+    bool isDirty = false;
     const std::string PATH = "";
-    int* tiles = NULL;
+    MappedFile file;    // The map file, mapped into memory when it isn't in the asset archive
+    unsigned char* tiles = NULL;    // First tile of the first map layer, inside either mapping
+    int bitsPerTile = 8;    // Size of each packed tile index
+    int mapLayers = 0;  // Number of map layers
     int sheetWidth = 0;
     int sheetHeight = 0;
     int mapCol = 0;
@@ -47,6 +58,17 @@ class Tilemap {
     ~Tilemap();
 
   public:
-    void draw();
+    void prepare();   // Rebake any changed or lost tiles, call before replaying a frame that shows the map
+    void draw(Render::Frame& frame);  // Add the map to the frame
+    void setTile(int col, int row, int frame, int mapLayer = 0);  // Change a tile, marking only its area for rebaking
+    int getTile(int col, int row, int mapLayer = 0) const;
+
+  private:
+    void markDirty(const SDL_Rect& region);   // Grow the dirty region to cover the given area
+    void bake();  // Redraw the dirty region of the layer
+
+    // Call copy(source, placement) for every tile overlapping the region
+    template <typename Copy>
+    void forEachTile(const SDL_Rect& region, Copy copy) const;
 };
 #endif
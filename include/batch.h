@@ -0,0 +1,35 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <SDL2/SDL.h>
+#include <vector>
+#include <iostream>
+
+// Sprite batch
+// Collects quads that share a texture and submits them in a single draw call
+class SpriteBatch {
+  private:
+    SDL_Texture* texture = NULL;  // Texture every quad in the batch samples
+    float textureWidth = 1.0f;    // Texture size, to convert source rects to texture coordinates
+    float textureHeight = 1.0f;
+    std::vector<SDL_Vertex> vertices;   // Four corners per quad
+    std::vector<int> indices;     // Two triangles per quad, only ever grows
+
+    // Totals across every batch, for reporting
+    static long long spritesDrawn;  // Quads submitted
+    static long long drawCalls;     // Draw calls used to submit them
+
+  public:
+    SpriteBatch() = default;
+    ~SpriteBatch() = default;
+
+  public:
+    void begin(SDL_Texture* sheet);   // Start a new batch sampling the given texture
+    void add(const SDL_Rect& source, const SDL_Rect& placement);  // Queue one quad
+    void flush();   // Submit every queued quad and empty the batch
+    int size() const { return static_cast<int>(vertices.size() / 4); }
+
+    static void report(std::ostream& out);  // Print how many draw calls batching saved
+};
+
+#endif
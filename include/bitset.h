@@ -0,0 +1,67 @@
+#ifndef BITSET_H
+#define BITSET_H
+
+#include <vector>
+#include <cstdint>
+#include <bit>
+
+// Packed set of flags, 64 per word
+// Loops over set bits skip whole empty words, so a mostly cleared set is cheap to walk
+class BitSet {
+  private:
+    std::vector<std::uint64_t> bits;
+    int length = 0;   // Number of flags held
+
+  public:
+    BitSet() = default;
+    BitSet(int size) { resize(size); }
+    ~BitSet() = default;
+
+  public:
+    void resize(int size) { length = size; bits.assign((size + 63) / 64, 0); }
+    int size() const { return length; }
+    int words() const { return static_cast<int>(bits.size()); }
+    std::uint64_t word(int index) const { return bits[index]; }
+    const std::uint64_t* data() const { return bits.data(); }
+
+    bool test(int index) const { return (bits[index / 64] >> (index % 64)) & 1; }
+    void set(int index) { bits[index / 64] |= std::uint64_t(1) << (index % 64); }
+    void reset(int index) { bits[index / 64] &= ~(std::uint64_t(1) << (index % 64)); }
+    void clear() { bits.assign(bits.size(), 0); }
+    void fill() {   // Set every flag, leaving the spare bits in the last word clear
+      bits.assign(bits.size(), ~std::uint64_t(0));
+      if(length % 64 != 0)
+        bits.back() = (std::uint64_t(1) << (length % 64)) - 1;
+    }
+
+    int count() const {   // Number of flags set
+      int total = 0;
+      for(std::uint64_t w : bits)
+        total += std::popcount(w);
+      return total;
+    }
+
+    // Call function(index) for each set flag in [first, last), lowest index first
+    template <typename Function>
+    void forEach(int first, int last, Function function) const {
+      if(first >= last)
+        return;
+      const int lastWord = (last - 1) / 64;
+      for(int w = first / 64; w <= lastWord; ++w) {
+        std::uint64_t word = bits[w];
+        if(w == first / 64)
+          word &= ~std::uint64_t(0) << (first % 64);   // Drop flags before first
+        if(w == lastWord && last % 64 != 0)
+          word &= (std::uint64_t(1) << (last % 64)) - 1;   // Drop flags from last on
+        while(word != 0) {
+          function(w * 64 + std::countr_zero(word));
+          word &= word - 1;   // Clear the lowest set bit
+        }
+      }
+    }
+
+    template <typename Function>
+    void forEach(Function function) const { forEach(0, length, function); }
+};
+
+#endif
@@ -0,0 +1,23 @@
+#ifndef COLLIDE_H
+#define COLLIDE_H
+
+#include <SDL2/SDL.h>
+#include <cstdint>
+#include <iostream>
+
+// Batch box overlap tests
+// One box is tested against many boxes stored as packed x and y arrays sharing a width and height
+// Hits come back as a bitmask, bit i of word i / 64 set when box i overlaps
+// The widest kernel the CPU supports (AVX2, SSE2 or plain scalar) is picked on first use
+namespace Collide {
+  inline int maskWords(int count) { return (count + 63) / 64; }  // Mask words needed for count boxes
+
+  // Test box against count boxes, fills maskWords(count) words of hits
+  // Returns true if anything overlapped
+  bool overlaps(const SDL_Rect& box, const int* x, const int* y, int width, int height, int count, std::uint64_t* hits);
+
+  const char* kernelName();   // Name of the kernel in use
+  void report(std::ostream& out);
+}
+
+#endif
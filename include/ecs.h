@@ -0,0 +1,130 @@
+#ifndef ECS_H
+#define ECS_H
+
+#include <vector>
+#include <cstdint>
+#include <iostream>
+#include <type_traits>
+#include "sprite.h"
+
+// Handle to an entity in a World
+// Slots are reused once an entity is destroyed, the generation tells the old entity from the new one
+struct Entity {
+  std::uint32_t index = 0;
+  std::uint32_t generation = 0;   // Never 0 for a live entity
+
+  bool operator==(const Entity& other) const = default;
+};
+const Entity NO_ENTITY = {};
+
+// One bit for each kind of component
+using ComponentMask = std::uint32_t;
+enum ComponentBit : ComponentMask {
+  TRANSFORM = 1 << 0,
+  SPRITE = 1 << 1,
+  ANIMATION = 1 << 2,
+  COLLIDER = 1 << 3,
+  LIFETIME = 1 << 4
+};
+
+template <typename Component> constexpr ComponentMask componentBit();
+template <> constexpr ComponentMask componentBit<Transform>() { return TRANSFORM; }
+template <> constexpr ComponentMask componentBit<Sprite>() { return SPRITE; }
+template <> constexpr ComponentMask componentBit<Animation>() { return ANIMATION; }
+template <> constexpr ComponentMask componentBit<Collider>() { return COLLIDER; }
+template <> constexpr ComponentMask componentBit<Lifetime>() { return LIFETIME; }
+
+// Every entity with the same set of components
+// Each component is packed in its own array, indexed by row, columns the archetype doesn't have stay empty
+struct Archetype {
+  ComponentMask mask = 0;
+  std::vector<Entity> entities;   // Entity in each row
+  std::vector<Transform> transforms;
+  std::vector<Sprite> sprites;
+  std::vector<Animation> animations;
+  std::vector<Collider> colliders;
+  std::vector<Lifetime> lifetimes;
+
+  int size() const { return static_cast<int>(entities.size()); }
+  template <typename Component> std::vector<Component>& column();
+};
+
+template <> inline std::vector<Transform>& Archetype::column<Transform>() { return transforms; }
+template <> inline std::vector<Sprite>& Archetype::column<Sprite>() { return sprites; }
+template <> inline std::vector<Animation>& Archetype::column<Animation>() { return animations; }
+template <> inline std::vector<Collider>& Archetype::column<Collider>() { return colliders; }
+template <> inline std::vector<Lifetime>& Archetype::column<Lifetime>() { return lifetimes; }
+
+// Entity storage
+// Entities are grouped into archetypes by the components they have, systems walk the packed arrays of each matching archetype
+// Destroying an entity swaps the last row of its archetype into the hole, so the arrays never have gaps
+// Don't create or destroy entities inside each(), collect them and do it after
+class World {
+  public:
+    static const int NO_SLOT = -1;
+
+  private:
+    // Where each entity slot lives
+    struct Record {
+      int archetype = NO_SLOT;
+      int row = NO_SLOT;    // Alive: row in the archetype. Free: next free slot
+      std::uint32_t generation = 0;
+    };
+
+    std::vector<Archetype> archetypes;
+    std::vector<Record> records;  // Indexed by Entity::index
+    int freeHead = NO_SLOT;   // First free slot
+    int live = 0;   // Entities alive
+
+    int findArchetype(ComponentMask mask);  // Index of the archetype for mask, made if there isn't one
+
+    template <typename Function, typename... Components>
+    static void eachRow(Archetype& archetype, Function& function, Components*... columns) {
+      const int count = archetype.size();
+      for(int row = 0; row < count; ++row) {
+        if constexpr(std::is_invocable_v<Function&, Entity, Components&...>)
+          function(archetype.entities[row], columns[row]...);
+        else
+          function(columns[row]...);
+      }
+    }
+
+  public:
+    World() = default;
+    ~World() = default;
+
+    friend std::ostream& operator<<(std::ostream& out, const World& world);
+
+  public:
+    Entity create(ComponentMask mask);  // New entity with default components
+    template <typename... Components>
+    Entity create() { return create((componentBit<Components>() | ... | 0)); }
+    void destroy(Entity entity);  // Destroy an entity, stale handles are ignored
+    void clear();   // Destroy every entity
+    bool isAlive(Entity entity) const;
+    int size() const { return live; }
+
+    // Component of an entity, NULL if it doesn't have one or is gone
+    template <typename Component>
+    Component* get(Entity entity) {
+      if(!isAlive(entity))
+        return NULL;
+      const Record& record = records[entity.index];
+      Archetype& archetype = archetypes[record.archetype];
+      if(!(archetype.mask & componentBit<Component>()))
+        return NULL;
+      return &archetype.column<Component>()[record.row];
+    }
+
+    // Call function(components&...) for every entity with all of the components, or function(entity, components&...)
+    template <typename... Components, typename Function>
+    void each(Function function) {
+      const ComponentMask required = (componentBit<Components>() | ... | 0);
+      for(Archetype& archetype : archetypes) {
+        if((archetype.mask & required) == required && archetype.size() > 0)
+          eachRow(archetype, function, archetype.column<Components>().data()...);
+      }
+    }
+};
+
+#endif
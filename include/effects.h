@@ -0,0 +1,25 @@
+#ifndef EFFECTS_H
+#define EFFECTS_H
+
+#include <cstdint>
+#include "types.h"
+#include "ecs.h"
+
+// Kinds of effect, each plays one strip of frames and then removes itself
+enum class EffectType : std::uint8_t {
+  explosion,    // Alien destroyed
+  playerHit,    // Slower burst when the player loses a life
+  MAX_TYPES
+};
+
+// One-shot animated effects
+// Each effect is an entity with a transform, sprite, animation and a lifetime that covers one pass of the strip
+// Effects all share one archetype, so the animation and lifetime systems walk them as packed arrays
+namespace Effects {
+  bool init();    // Load every effect sheet
+  void destroy();   // Forget every effect sheet
+  Entity spawn(World& world, EffectType type, const Point2d& center, int delay = 0);   // Start an effect centered on a point after delay ticks
+  void clear(World& world);   // Remove every effect
+}
+
+#endif
@@ -7,16 +7,18 @@
 namespace SDL {
   extern SDL_Window* gameWindow;
   extern SDL_Renderer* renderer;
-  extern SDL_Surface* tempSurface;
   extern bool alien_init;
   extern bool bullet_init;
   extern bool static_init;  // Track static class variable initialization state to be used as an invariant
+  extern bool targetsLost;  // Set when the renderer discards render target contents
+  extern bool windowExposed;  // Set when the window has to be drawn again in full
   
   bool ProgramIsRunning();
   void FillRect(SDL_Rect &rect, int x, int y, int width, int height);
-  SDL_Surface* loadImage(std::string path);
+  SDL_Surface* loadImage(std::string path);   // Safe to call from any thread
   SDL_Texture* loadTexture(SDL_Surface* surface);
   SDL_Surface* setTransparentColor (SDL_Surface* surface, Uint8 r, Uint8 g, Uint8 b);
+  bool readImageSize(std::string path, int& width, int& height);  // Read bitmap dimensions from the asset archive or the file header
   bool Init();
   void CloseShop();
 }
@@ -0,0 +1,18 @@
+#ifndef HUD_H
+#define HUD_H
+
+#include <iostream>
+#include "render.h"
+
+// Heads-up display
+// Score and lives are drawn in a 5x7 bitmap font, rasterized once onto a small glyph sheet
+// Each line is laid out again only when its number changes, every frame just appends the cached glyph copies
+// All on the render thread, it owns the glyph sheet
+namespace Hud {
+  bool init();    // Rasterize the glyph sheet
+  void draw(Render::Frame& frame);  // Add the frame's score and lives over everything else, as one run of copies from the sheet
+  void destroy();   // Free the glyph sheet
+  void report(std::ostream& out);   // Print how often the lines had to be laid out again
+}
+
+#endif
@@ -0,0 +1,99 @@
+#ifndef JOBS_H
+#define JOBS_H
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <functional>
+#include <algorithm>
+#include <iostream>
+
+// Work-stealing job system
+// Every thread, the main one included, owns a queue of jobs. A thread pushes and pops at the back of its own queue,
+// so it works on what it queued most recently while it is still in cache, and idle threads steal from the front of the others
+// Waiting for jobs to finish never blocks, the waiting thread runs queued jobs until its own are done
+// Threads outside the pool all share queue 0, so only one of them may use Jobs at a time. The main thread loads
+// with it before the simulation thread starts, then leaves it to the simulation until that thread has joined
+namespace Jobs {
+  // One unit of work, run(context, index)
+  struct Job {
+    void (*run)(void* context, int index) = NULL;
+    void* context = NULL;
+    int index = 0;
+    std::atomic<int>* pending = NULL;   // Decremented once the job has run
+  };
+
+  void init(int threads);   // Start the workers, threads counts the main thread, 0 for one per core
+  void shutdown();  // Stop and join the workers
+  int threadCount();    // Worker threads plus the main thread
+  int threadIndex();    // 0 on any thread outside the pool, 1 and up on the workers, for indexing per-thread buffers
+
+  void submit(const Job& job);  // Queue a job on the calling thread's queue
+  void wait(const std::atomic<int>& pending);   // Run jobs until pending reaches 0
+  bool tryRun();  // Run one queued job on this thread, false if none were waiting
+
+  // Number of chunks parallelFor splits count items into
+  // Chunks depend only on count and grain, never on the thread count, so per-chunk results can be merged in a fixed order
+  inline int chunkCount(int count, int grain) { return count <= 0 ? 0 : (count + grain - 1) / grain; }
+
+  // Call body(chunk, first, last) for every chunk of grain items in [0, count), spread across the threads
+  // Returns once every chunk has run. A single chunk runs inline on the calling thread
+  template <typename Body>
+  void parallelFor(int count, int grain, const Body& body) {
+    const int chunks = chunkCount(count, grain < 1 ? 1 : grain);
+    if(chunks <= 1 || threadCount() <= 1) {
+      for(int chunk = 0; chunk < chunks; ++chunk)
+        body(chunk, chunk * grain, std::min(count, (chunk + 1) * grain));
+      return;
+    }
+    struct Range {
+      const Body* body;
+      int count;
+      int grain;
+    } range = { &body, count, grain };
+    std::atomic<int> pending{ chunks };
+    for(int chunk = chunks - 1; chunk >= 0; --chunk) {  // Queued backwards so this thread pops the first chunk first
+      Job job;
+      job.run = [](void* context, int chunk) {
+        const Range* range = static_cast<const Range*>(context);
+        (*range->body)(chunk, chunk * range->grain, std::min(range->count, (chunk + 1) * range->grain));
+      };
+      job.context = &range;
+      job.index = chunk;
+      job.pending = &pending;
+      submit(job);
+    }
+    wait(pending);
+  }
+
+  void report(std::ostream& out);   // Print how many jobs ran and how many were stolen
+}
+
+// Tasks with dependencies between them
+// Build the graph once, then run it as often as needed. A task is queued as soon as every task it waits on has finished
+class TaskGraph {
+  private:
+    struct Task {
+      std::function<void()> work;
+      std::vector<int> dependents;  // Tasks waiting on this one
+      int dependencies = 0;   // Tasks this one waits on
+      std::atomic<int> waiting{ 0 };  // Dependencies left to finish on this run
+    };
+    std::vector<std::unique_ptr<Task>> tasks;
+    std::atomic<int> pending{ 0 };  // Tasks left to finish on this run
+    std::vector<int> ready;   // Tasks ready to run, when running on a single thread
+
+    static void runTask(void* context, int index);
+
+  public:
+    TaskGraph() = default;
+    ~TaskGraph() = default;
+
+  public:
+    int add(std::function<void()> work);  // Add a task, returns its id
+    void precede(int before, int after);  // after waits for before to finish
+    void run();   // Run every task, returns once they have all finished
+    int size() const { return static_cast<int>(tasks.size()); }
+};
+
+#endif
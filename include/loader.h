@@ -0,0 +1,25 @@
+#ifndef LOADER_H
+#define LOADER_H
+
+#include <SDL2/SDL.h>
+#include <string>
+#include <functional>
+#include <iostream>
+
+// Asynchronous asset loading
+// Images are decoded into surfaces on the job threads, decodes start in the order they were requested but can finish in any order
+// Only the thread that owns the renderer can make textures, so it uploads the decoded surfaces a few at a time between frames
+namespace Loader {
+  using Decode = std::function<SDL_Surface*()>;   // Runs on any thread, returns the decoded image or NULL
+  using Upload = std::function<bool(SDL_Surface*)>;   // Runs on the render thread, turns the image into a texture
+
+  void request(const std::string& name, Decode decode, Upload upload);  // Queue an image to load
+  bool update(double budgetMs);   // Upload decoded images for up to budgetMs, helping decode if none are ready. False if any failed
+  bool done();    // Has every image requested been uploaded?
+  float progress();   // Fraction of the images requested that have been uploaded
+  void abandon();   // Wait for decodes in flight and drop everything not uploaded yet
+  void firstFrame();  // Note the first frame is on screen, only the first call counts
+  void report(std::ostream& out);   // Print how long loading and the first frame took
+}
+
+#endif
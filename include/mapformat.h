@@ -0,0 +1,38 @@
+#ifndef MAPFORMAT_H
+#define MAPFORMAT_H
+
+#include <cstdint>
+
+// Binary tilemap format (.tmb)
+// A fixed header followed by every layer's tile indices, row by row, packed at 8 or 16 bits per tile
+// All values are little-endian, the file is used in place straight from a memory mapping
+namespace mapformat {
+  const char MAGIC[4] = { 'T', 'M', 'A', 'P' };
+  const std::uint16_t VERSION = 1;
+
+  struct Header {
+    char magic[4];    // Always MAGIC
+    std::uint16_t version;      // Format version, VERSION
+    std::uint16_t bitsPerTile;  // 8 or 16
+    std::uint16_t columns;      // Map width in tiles
+    std::uint16_t rows;         // Map height in tiles
+    std::uint16_t tileWidth;    // Tile size in pixels
+    std::uint16_t tileHeight;
+    std::uint16_t sheetId;      // Index into SHEETS
+    std::uint16_t layerCount;   // Number of layers, drawn first to last
+    std::uint32_t dataOffset;   // Byte offset of the first tile from the start of the file
+  };
+  static_assert(sizeof(Header) == 24, "Tilemap header must stay packed");
+
+  // Tile sheets a map can refer to by id
+  struct Sheet {
+    const char* path;
+    const char* transparency;   // Hex color to treat as transparent
+  };
+  const Sheet SHEETS[] = {
+    { "graphics/tiles.bmp", "#00ff00" }   // 0
+  };
+  const int SHEET_COUNT = sizeof(SHEETS) / sizeof(SHEETS[0]);
+}
+
+#endif
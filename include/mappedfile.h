@@ -0,0 +1,32 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <string>
+#include <cstddef>
+
+// Private, copy-on-write mapping of a whole file
+// Writes through data() stay private to this process and never reach the file
+class MappedFile {
+  private:
+    unsigned char* bytes = nullptr;   // Start of the mapping
+    std::size_t length = 0;   // Size of the mapping in bytes
+#ifdef _WIN32
+    void* fileHandle = nullptr;
+    void* mappingHandle = nullptr;
+#endif
+
+  public:
+    MappedFile() = default;
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+  public:
+    bool open(const std::string& path);   // Map the file, returns false if it can't be mapped
+    void close();
+    bool isOpen() const { return bytes != nullptr; }
+    unsigned char* data() const { return bytes; }
+    std::size_t size() const { return length; }
+};
+
+#endif
@@ -0,0 +1,39 @@
+#ifndef PACER_H
+#define PACER_H
+
+#include <SDL2/SDL.h>
+#include <iostream>
+
+// Frame pacer
+// Releases frames on a fixed schedule read off the performance counter, so time spent drawing doesn't add to the period
+// Most of each wait is slept, the last stretch is spun so the wake-up lands on the deadline
+// With vsync the present already waits for the display, so frames are only measured against the refresh period
+class FramePacer {
+  private:
+    static constexpr double SPIN_SECONDS = 0.002;   // Left to spin after sleeping, covers the scheduler waking us late
+    Uint64 frequency = 0;   // Performance counter ticks per second
+    Uint64 period = 0;      // Counter ticks per frame, 0 for uncapped
+    Uint64 spinLength = 0;  // SPIN_SECONDS in counter ticks
+    bool vsync = false;     // The present waits for the display
+    Uint64 deadline = 0;    // When the next frame is due
+    Uint64 released = 0;    // Counter when the last frame was released, 0 to start a new schedule
+
+    // Totals for reporting, intervals in counter ticks
+    long long intervals = 0;    // Frame to frame intervals measured
+    long long missed = 0;       // Frames that were still being drawn when they were due
+    double intervalSum = 0.0;
+    double intervalSquares = 0.0;   // For the standard deviation
+    double worstDeviation = 0.0;  // Furthest any interval was from the period
+
+  public:
+    FramePacer() = default;
+    ~FramePacer() = default;
+
+  public:
+    void setTarget(int fps, bool vsyncOn);  // Frames per second to hold, 0 for uncapped. With vsync, the display's refresh rate
+    void reset();   // Start a new schedule from the next frame, after a pause or a change of screen
+    void wait();    // Hold the frame just presented until the next one is due
+    void report(std::ostream& out) const;   // Print the average frame time, jitter and missed deadlines
+};
+
+#endif
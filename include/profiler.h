@@ -0,0 +1,53 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <SDL2/SDL.h>
+#include <atomic>
+#include <string>
+
+// Scoped hot path profiler
+// PROFILE_SCOPE("name") times the rest of the enclosing block while a trace is being recorded
+// Each thread writes its timings into its own ring buffer, so recording never takes a lock
+// The chosen frame range is written out as a Chrome trace, viewable in chrome://tracing or Perfetto
+// Build with ENABLE_PROFILER off and every PROFILE_SCOPE compiles to nothing
+namespace Profiler {
+  extern std::atomic<bool> recording;   // Is the current frame inside the traced range?
+
+  void record(const char* name, Uint64 start, Uint64 end);  // Store one timing on this thread's ring
+
+  // Times its own lifetime
+  class Scope {
+    private:
+      const char* name;
+      Uint64 start = 0;
+      bool active;
+
+    public:
+      Scope(const char* scopeName)
+        : name{ scopeName }, active{ recording.load(std::memory_order_relaxed) }
+      {
+        if(active)
+          start = SDL_GetPerformanceCounter();
+      }
+      ~Scope() {
+        if(active)
+          record(name, start, SDL_GetPerformanceCounter());
+      }
+      Scope(const Scope&) = delete;
+      Scope& operator=(const Scope&) = delete;
+  };
+
+  void configure(const std::string& path, int firstFrame, int lastFrame);   // Trace frames first to last into path
+  void frame();   // Mark the start of a frame, call once per frame from the main loop
+  void finish();  // Write out the trace, call once every other thread that records has stopped
+}
+
+#ifdef ENABLE_PROFILER
+  #define PROFILE_JOIN2(a, b) a##b
+  #define PROFILE_JOIN(a, b) PROFILE_JOIN2(a, b)
+  #define PROFILE_SCOPE(name) Profiler::Scope PROFILE_JOIN(profileScope, __LINE__)(name)
+#else
+  #define PROFILE_SCOPE(name) ((void)0)
+#endif
+
+#endif
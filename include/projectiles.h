@@ -0,0 +1,103 @@
+#ifndef PROJECTILES_H
+#define PROJECTILES_H
+
+#include <SDL2/SDL.h>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <iostream>
+#include "types.h"
+#include "resources.h"
+#include "render.h"
+#include "spatialhash.h"
+
+class AlienSwarm;
+
+// Static variables for the projectile texture
+extern TextureHandle bulletTextureSheet;   // Texture sheet to share for all projectiles
+extern std::string bulletSheetPath;
+extern std::string bulletTransparency;
+extern int bulletTimer;   // Ticks since the player last fired
+
+// Who fired a projectile, decides what it can hit
+enum class Owner : std::uint8_t {
+  player,
+  alien
+};
+
+// Fixed capacity pool of projectiles
+// Every slot is allocated up front, so firing never allocates
+// Free slots are chained through link into a free list, slots in flight are kept in a dense list for iteration
+// Each attribute is stored in its own contiguous array, indexed by slot
+class ProjectilePool {
+  public:
+    static constexpr int MAX_CAPACITY = 100000;
+    static const int PLAYER_SPEED = 15;   // Pixels a player shot climbs each tick
+    static const int FAN_SPEED = 6;       // Sideways pixels per tick of the outermost shots in a volley
+    static const int CELL_SIZE = 128;     // Broadphase cell size, about the size of an alien plus its gap
+    static const int NO_SLOT = -1;
+    static const int SHOT_GRAIN = 256;    // Shots per chunk when collision checks are split across threads
+
+  private:
+    // Narrowphase scratch, one per thread, padded so threads don't share a cache line
+    struct alignas(64) Scratch {
+      std::vector<int> candidates;  // Aliens sharing a cell with the current projectile
+      std::vector<int> candidateX;  // Their locations, packed for the collision kernel
+      std::vector<int> candidateY;
+      std::vector<std::uint64_t> hitMask;   // Which candidates the projectile overlaps
+      SpatialHash::QueryState query;
+    };
+
+    // A shot overlapping an alien, found in parallel and acted on afterwards in a fixed order
+    struct Contact {
+      int index;  // Position of the shot in the active list
+      int alien;
+    };
+    struct alignas(64) ChunkContacts {
+      std::vector<Contact> found;
+    };
+
+    int capacity = 0;
+    int width = 0;    // Size of a projectile, shared by all
+    int height = 0;
+
+    // Per-slot data
+    std::vector<int> xPos;    // Current location
+    std::vector<int> yPos;
+    std::vector<int> xPrev;   // Location on the previous tick, for interpolation
+    std::vector<int> yPrev;
+    std::vector<int> xVelocity;   // Pixels moved each tick
+    std::vector<int> yVelocity;
+    std::vector<Owner> owners;
+    std::vector<int> link;    // In flight: position in the active list. Free: next free slot
+
+    int freeHead = NO_SLOT;   // First free slot
+    std::vector<int> active;  // Slots in flight, densely packed
+
+    SpatialHash grid;   // Living aliens bucketed by cell, rebuilt every check
+    std::vector<Scratch> threadScratch;   // Indexed by thread
+    std::vector<ChunkContacts> contacts;   // Indexed by chunk
+
+    void findContacts(const AlienSwarm& swarm, int first, int last, Scratch& scratch, std::vector<Contact>& found) const;  // Narrowphase for the shots in [first, last) of the active list
+
+  public:
+    ProjectilePool(int capacity);
+    ~ProjectilePool() = default;
+
+    friend std::ostream& operator<<(std::ostream& out, const ProjectilePool& pool);
+
+  public:
+    static bool init();   // Load the shared projectile texture
+    int acquire(Owner owner, const Point2d& location, int xSpeed, int ySpeed);   // Launch a projectile, NO_SLOT if the pool is full
+    void release(int slot);   // Return a projectile to the pool
+    void clear();   // Release every projectile
+    bool fire(const SDL_Rect& shooter);  // Player volley from the middle of the shooter, limited by the fire delay
+    void update();
+    void draw(Render::Frame& frame, float alpha = 1.0f);  // Add a copy for every projectile in flight to the frame
+    int checkCollisions(AlienSwarm& swarm);   // Player shots against the swarm, returns the number of aliens hit
+    int size() const { return static_cast<int>(active.size()); }
+    int getCapacity() const { return capacity; }
+    std::uint32_t checksum(std::uint32_t hash) const;   // Fold every projectile in flight into a hash
+};
+
+#endif
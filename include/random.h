@@ -0,0 +1,24 @@
+#ifndef RANDOM_H
+#define RANDOM_H
+
+#include <cstdint>
+
+// Seedable random number generator (PCG32)
+// Every random choice in a game comes from gameRandom, so a game is reproduced by replaying its seed
+class Random {
+  private:
+    std::uint64_t state = 0;
+    std::uint64_t increment = 1442695040888963407ULL;   // Stream selector, must be odd
+
+  public:
+    Random(std::uint64_t seed = 0) { this->seed(seed); }
+
+  public:
+    void seed(std::uint64_t seed);  // Restart the sequence
+    std::uint32_t next();   // Next 32 random bits
+    int below(int bound);   // Random value in [0, bound)
+};
+
+extern Random gameRandom;   // Generator for everything that affects gameplay
+
+#endif
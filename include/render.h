@@ -0,0 +1,76 @@
+#ifndef RENDER_H
+#define RENDER_H
+
+#include <SDL2/SDL.h>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <iostream>
+#include "sprite.h"
+
+// Render command lists
+// The simulation describes each frame as a list of texture copies instead of drawing it
+// Only the thread that owns SDL::renderer replays the lists, so a slow present never holds up a tick
+namespace Render {
+  // Copy part of a texture to the screen, or fill a rectangle with a color if there is no texture
+  struct Command {
+    SDL_Texture* texture = NULL;
+    SDL_Rect source = { 0, 0, 0, 0 };   // Zero width copies the whole texture
+    SDL_Rect placement = { 0, 0, 0, 0 };
+    Layer layer = Layer::actors;
+    SDL_Color color = { 0, 0, 0, 255 };   // Fill color
+  };
+
+  // Everything needed to put one frame on screen
+  struct Frame {
+    std::vector<Command> commands;  // Drawn in layer order, then in the order they were added
+    int score = 0;    // Shown on the HUD
+    int lives = 0;
+
+    void clear() { commands.clear(); }
+    void add(Layer layer, SDL_Texture* texture, const SDL_Rect& source, const SDL_Rect& placement) {
+      commands.push_back({ texture, source, placement, layer });
+    }
+    void addWhole(Layer layer, SDL_Texture* texture, const SDL_Rect& placement) {  // Copy the whole texture
+      commands.push_back({ texture, { 0, 0, 0, 0 }, placement, layer });
+    }
+    void fill(Layer layer, const SDL_Rect& placement, const SDL_Color& color) {
+      commands.push_back({ NULL, { 0, 0, 0, 0 }, placement, layer, color });
+    }
+  };
+
+  void draw(Frame& frame);  // Clear the screen, replay the frame and present it, render thread only
+                            // With --dirty-rects only the parts that changed since the last frame are redrawn
+  void invalidate(const SDL_Rect& rect);  // Redraw this part of the screen next frame, for textures changed in place
+  void fitField();  // Lay frames out on the playfield from now on, scaled down to the window if it was stretched
+  SDL_Rect stretch(const SDL_Rect& rect);   // Scale a rectangle laid out on the window up to the playfield
+  void report(std::ostream& out);   // Print how many frames were drawn and how many never made it to the screen
+}
+
+// Triple buffered hand-off of frames from the simulation to the render thread
+// The simulation always has a frame of its own to fill and the render thread always has one to draw,
+// the third holds the newest finished frame. Publishing replaces it if it hasn't been taken yet, so neither side waits on the other
+class FrameQueue {
+  private:
+    Render::Frame frames[3];
+    int writing = 0;  // Being filled by the simulation
+    int ready = 1;    // Newest finished frame
+    int reading = 2;  // Being drawn by the render thread
+    bool fresh = false;   // Ready holds a frame the render thread hasn't taken
+    bool closed = false;  // No more frames are coming
+    std::mutex mutex;   // Only held to swap indices
+    std::condition_variable changed;
+
+  public:
+    FrameQueue() = default;
+    ~FrameQueue() = default;
+
+  public:
+    Render::Frame& back() { return frames[writing]; }   // Frame for the simulation to fill
+    void publish();   // Hand the back frame over to the render thread
+    Render::Frame* acquire(int timeoutMs);  // Newest frame not yet drawn, waiting up to timeoutMs for one, NULL if none came
+    void waitTaken(int timeoutMs);  // Wait up to timeoutMs for the render thread to take the last frame published
+    void close();     // Wake both sides for good, when either one stops
+};
+
+#endif
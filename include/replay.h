@@ -0,0 +1,41 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <SDL2/SDL.h>
+#include <cstdint>
+#include <string>
+#include <iostream>
+
+// Input recording and deterministic playback
+// A replay file holds the game seed, tick rate and gameplay settings, then one record per tick: the buttons held and a hash of the game state after the tick
+// Playing one back puts the settings back, feeds the recorded buttons to the game and checks every tick hashes the same
+//
+// File layout, little-endian:
+//   char[4] magic "RPLY", uint16 version, uint16 tick rate, uint64 seed
+//   int32 projectiles, swarm rows, swarm columns, gap, gutter, swarm speed, volley, fire delay (version 2 on, version 1 stops at the seed)
+//   per tick: uint8 buttons, uint32 state hash
+namespace Replay {
+  // Buttons held during a tick, packed into one byte
+  enum Button : Uint8 {
+    LEFT = 1 << 0,
+    RIGHT = 1 << 1,
+    FIRE = 1 << 2
+  };
+  Uint8 readKeyboard(const Uint8* keys);  // Pack the keyboard state into buttons
+
+  // Recording
+  bool startRecording(const std::string& path, std::uint64_t seed, int tickRate);  // Saves the gameplay settings along with the seed
+  void record(Uint8 buttons, std::uint32_t stateHash);  // Append one tick
+  void stopRecording();
+  bool isRecording();
+
+  // Playback
+  bool load(const std::string& path, std::uint64_t& seed, int& tickRate);  // Read a replay, take its settings and start playing it
+  bool isPlaying();
+  bool next(Uint8& buttons);  // Buttons for the next tick, false once the replay runs out
+  bool finished();  // Has every recorded tick been played?
+  void verify(std::uint32_t stateHash);  // Check the tick just played against the recording
+  void report(std::ostream& out);   // Print how many ticks matched
+}
+
+#endif
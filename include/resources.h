@@ -0,0 +1,55 @@
+#ifndef RESOURCES_H
+#define RESOURCES_H
+
+#include <SDL2/SDL.h>
+#include <string>
+#include <memory>
+#include <cstddef>
+#include <iostream>
+#include "types.h"
+
+namespace Resources {
+  // A cached texture and its bookkeeping
+  struct Texture {
+    std::string key;    // Asset path plus color key
+    SDL_Texture* texture = NULL;
+    int width = 0;
+    int height = 0;
+    std::size_t bytes = 0;    // Texture memory held
+    unsigned long long lastUsed = 0;  // Stamp of the last load, for LRU eviction
+  };
+}
+
+// Shared handle to a cached texture
+// The texture stays loaded while any handle to it exists
+class TextureHandle {
+  private:
+    std::shared_ptr<Resources::Texture> entry;
+
+  public:
+    TextureHandle() = default;
+    TextureHandle(std::shared_ptr<Resources::Texture> cached) : entry{ cached } {}
+
+  public:
+    SDL_Texture* get() const { return entry ? entry->texture : NULL; }
+    int getWidth() const { return entry ? entry->width : 0; }
+    int getHeight() const { return entry ? entry->height : 0; }
+    void reset() { entry.reset(); }
+    explicit operator bool() const { return get() != NULL; }
+};
+
+// Texture cache
+// Loads are deduplicated by path and color key, unreferenced textures stay cached until the budget needs the space
+namespace Resources {
+  TextureHandle load(const std::string& path);  // Load a bitmap with no transparency
+  TextureHandle load(const std::string& path, const RGB& transparency);   // Load a bitmap with a color key
+  TextureHandle adopt(const std::string& key, SDL_Texture* texture);  // Track a texture created elsewhere
+  void preload(const std::string& path);  // Decode a bitmap in the background, later loads of it come from the cache
+  void preload(const std::string& path, const RGB& transparency);
+  TextureHandle peek(const std::string& path);  // The cached texture for a bitmap with no transparency, empty if it isn't loaded yet
+  void setBudget(std::size_t bytes);  // Most texture memory to hold before evicting unreferenced textures
+  void report(std::ostream& out);   // Print memory held by each texture
+  void shutdown();  // Free every texture, call before the renderer goes away
+}
+
+#endif
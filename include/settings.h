@@ -2,12 +2,45 @@
 #define SETTINGS_H
 
 #include <string>
+#include <cstdint>
 
 namespace settings {
   // Set up global game constants
   const int SCREEN_WIDTH = 1600;
   const int SCREEN_HEIGHT = 900;
   const int NUM_ROUNDS = 3;
+
+  // Runtime options, overridden from the command line
+  extern int tickRate;    // Simulation ticks per second
+  extern int maxFps;      // Render frame cap, 0 for uncapped
+  extern bool vsync;      // Present in sync with the display refresh
+  extern bool headless;   // Simulate with no window, renderer or frame delay
+  extern int headlessGames;   // Number of games to simulate in headless mode
+  extern int textureBudgetMB;   // Texture memory to hold before evicting unused textures
+  extern int projectileCapacity;  // Projectiles that can be in flight at once
+  extern std::string traceFile;   // Where to write a Chrome trace, empty for none
+  extern int traceFirstFrame;     // Frames to record in the trace
+  extern int traceLastFrame;
+  extern std::uint64_t seed;        // Seed for the game's random numbers
+  extern std::string recordFile;    // Where to record a replay, empty for none
+  extern std::string replayFile;    // Replay to play back, empty for none
+  extern bool replayFast;           // Play the replay back as fast as possible
+  extern int threads;     // Threads to spread work across, 0 for one per core
+  extern bool dirtyRects;   // Software rendering that only redraws what changed
+
+  // Swarm and playfield, from the command line, a config file or a preset
+  extern int swarmRows;     // Rows of aliens in each wave
+  extern int swarmColumns;  // Aliens in each row
+  extern int swarmGap;      // Space between aliens
+  extern int swarmGutter;   // Space either side of a wave as it starts
+  extern int swarmSpeed;    // Window pixels a row moves each tick in the first round, times the round number after that
+  extern int volley;        // Shots fired at once, fanned out
+  extern int fireDelay;     // Ticks between volleys
+  extern int fieldWidth;    // Logical size of the playfield, grown to hold the swarm and scaled to fit the window
+  extern int fieldHeight;
+
+  bool parseArgs(int argc, char* argv[]);  // Read options from the command line
+  int stretch(int length);  // Scale a length on the window up to the playfield
 }
 
 #endif
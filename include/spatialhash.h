@@ -0,0 +1,59 @@
+#ifndef SPATIALHASH_H
+#define SPATIALHASH_H
+
+#include <SDL2/SDL.h>
+#include <vector>
+#include <iostream>
+
+// Uniform grid broadphase
+// Items are bucketed into every cell their box overlaps, queries only visit the cells they cover
+// The grid is rebuilt from scratch each tick with a counting sort over just the cells items landed in
+// Building and clearing cost grows with the items, not the cells, so a huge mostly empty field stays cheap
+class SpatialHash {
+  public:
+    // Scratch for running queries, each thread querying at once needs its own
+    struct QueryState {
+      std::vector<unsigned> lastSeen;   // Query stamp per id, so items spanning cells come back once
+      unsigned stamp = 0;
+      long long queries = 0;      // Counts since the last tally()
+      long long candidates = 0;
+    };
+
+  private:
+    int cellSize = 1;   // Width and height of a cell in pixels
+    int columns = 1;    // Cells across the grid
+    int rows = 1;       // Cells down the grid
+
+    std::vector<int> cellCount;   // Items in each cell, zero for every cell not in touched
+    std::vector<int> cellStart;   // Offset of each cell's items in cellItems, only meaningful while the count is non-zero
+    std::vector<int> cellNext;    // Write position in each cell while building
+    std::vector<int> touched;     // Cells holding at least one item, the only ones clear has to reset
+    std::vector<int> cellItems;   // Item ids grouped by cell
+    std::vector<int> pendingIds;  // Items inserted since the last clear
+    std::vector<SDL_Rect> pendingBoxes;
+    int idLimit = 0;    // One past the largest id inserted
+    QueryState state;   // Scratch for queries made without their own
+
+    // Totals across every query, for reporting
+    static long long candidatesFound;   // Items handed to a narrowphase
+    static long long queriesRun;
+
+  public:
+    SpatialHash(int cellSize, int width, int height);   // Grid covering width x height pixels
+    ~SpatialHash() = default;
+
+  public:
+    void clear();   // Drop every item
+    void insert(int id, const SDL_Rect& box);   // Queue an item, ids should be small and dense
+    void build();   // Bucket everything inserted since the last clear
+    void query(const SDL_Rect& area, std::vector<int>& found);  // Append the ids of items sharing a cell with area
+    void query(const SDL_Rect& area, std::vector<int>& found, QueryState& scratch) const;  // Same, safe to call from several threads at once
+
+    static void tally(QueryState& scratch);   // Add a scratch's counts to the report totals and zero them
+    static void report(std::ostream& out);  // Print how many candidates queries returned
+
+  private:
+    void cellRange(const SDL_Rect& box, int& firstCol, int& firstRow, int& lastCol, int& lastRow) const;
+};
+
+#endif
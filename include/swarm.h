@@ -0,0 +1,95 @@
+#ifndef SWARM_H
+#define SWARM_H
+
+#include <SDL2/SDL.h>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <iostream>
+#include "types.h"
+#include "resources.h"
+#include "render.h"
+#include "bitset.h"
+
+// Static variables for alien texture
+extern TextureHandle alienTextureSheet;     // Texture sheet to share for all aliens
+extern std::string alienSheetPath;
+extern std::string alienTransparency;
+
+// Hold the entire swarm of aliens
+// Each alien attribute is stored in its own contiguous array, indexed by row * columns + column
+class AlienSwarm {
+  public:
+    static const int ALIEN_GRAIN = 4096;    // Aliens per chunk when an update is split across threads
+
+  private:
+    static const int BASE_LINE = 25*32;        // Top of the player's base on the window
+    static const int MAX_SPRITE_FRAME = 2;     // Number of animation frames on the sheet
+
+    //Enum class to hold color values
+    enum class Color : int {  // Integral type - value corresponds with y-offset on the sheet
+      blue,      // 0
+      brown,       // 1
+      gray,       // 2
+      green,       // 3
+      orange,      // 4
+      pink,     // 5
+      purple,      // 6
+      red,        // 7
+      yellow,     // 8
+      MAX_COLORS  // Size - allows us to work with the sheet easier
+    };
+
+    int rows = 0;     // Number of rows in the swarm
+    int columns = 0;  // Number of aliens in each row
+    int count = 0;    // Total number of aliens
+    int width = 0;    // Width of a single alien
+    int height = 0;   // Height of a single alien
+    int speed = 1;    // Pixels moved per tick
+    int remaining = 0;    // Number of aliens left alive, kept as they die so the cleared check is O(1)
+
+    // Per-alien data
+    std::vector<int> xPos;    // Current location
+    std::vector<int> yPos;
+    std::vector<int> xPrev;   // Location on the previous tick, for interpolation
+    std::vector<int> yPrev;
+    std::vector<std::uint8_t> colors;   // Color, the row on the sheet
+    std::vector<std::uint8_t> frames;   // Current animation frame
+    std::vector<std::uint8_t> frameCounters;  // Ticks since the last frame change
+    std::vector<std::uint8_t> frameDelays;    // Ticks to hold each frame for
+    BitSet alive;   // Alive flags, loops walk only the set bits
+    std::vector<std::uint64_t> hitMask; // Scratch bitmask for the collision kernel
+
+    // Per-row data
+    std::vector<int> rowVelocity;   // Direction * speed the row moves each tick
+
+    // Per-column data
+    std::vector<int> lowestAlive;   // Row of the bottom living alien in each column, -1 once the column is cleared
+
+    void moveRows(int firstRow, int lastRow);   // Move a run of rows, bouncing off the screen edges
+
+  public:
+    AlienSwarm(int rowCount, int columnCount, int speed);
+    ~AlienSwarm() = default;
+
+    friend std::ostream& operator<<(std::ostream& out, const AlienSwarm& swarm);
+
+  public:
+    static bool init();   // Load the shared alien texture
+    static void fitField();   // Grow the playfield to hold the configured swarm, once init has the alien size
+    bool checkCollisions(const SDL_Rect& playerBox);
+    void resetLocation();
+    void resetRound(int round);
+    void update();
+    void draw(Render::Frame& frame, float alpha = 1.0f);  // Add a copy for every living alien to the frame
+    bool isEmpty() const { return remaining == 0; }
+    int size() const { return count; }
+    int aliveCount() const { return alive.count(); }
+    int lowestInColumn(int column) const { return lowestAlive[column]; }  // Row of the bottom living alien, -1 if none
+    std::uint32_t checksum(std::uint32_t hash) const;   // Fold the swarm state into a hash
+    void destroy(int index);  // Mark an alien as destroyed
+
+    friend class ProjectilePool;   // Allow projectiles to access members so we can determine collisions
+};
+
+#endif
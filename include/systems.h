@@ -0,0 +1,20 @@
+#ifndef SYSTEMS_H
+#define SYSTEMS_H
+
+#include <SDL2/SDL.h>
+#include "ecs.h"
+#include "sprite.h"
+#include "render.h"
+
+// Behavior for the entities in a World
+// Each system walks the packed component arrays of every archetype it needs
+namespace Systems {
+  void snapshot(World& world);  // Remember where every entity is, run at the start of a tick before anything moves
+  void animate(World& world);   // Step every animation along its strip
+  void age(World& world);       // Count down lifetimes and destroy the entities that ran out
+  void render(World& world, Render::Frame& frame, Layer layer, float alpha);  // Add the visible sprites on a layer to the frame, interpolated between ticks
+  void snap(World& world, Entity entity);   // Jump straight to the current position without interpolating
+  SDL_Rect bounds(World& world, Entity entity);   // Collider box of an entity
+}
+
+#endif
@@ -0,0 +1,29 @@
+#ifndef TIMESTEP_H
+#define TIMESTEP_H
+
+#include <SDL2/SDL.h>
+
+// Fixed timestep accumulator
+// Decouples the simulation tick rate from the render frame rate
+class FixedTimestep {
+  private:
+    static const int MAX_STEPS = 5;   // Most ticks to run per frame before dropping time
+    Uint64 frequency = 0;     // Performance counter ticks per second
+    Uint64 stepLength = 0;    // Performance counter ticks per simulation step
+    Uint64 previous = 0;      // Counter value at the last call to advance()
+    Uint64 accumulator = 0;   // Unsimulated time carried between frames
+
+  public:
+    FixedTimestep(int tickRate);
+    ~FixedTimestep() = default;
+
+  public:
+    void reset();     // Restart timing from now, discarding any carried time
+    void advance();   // Add the time elapsed since the last call to the accumulator
+    bool step();      // Consume one tick if one is due
+    float alpha() const;  // Fraction of a tick between the last step and now, for interpolation
+    int msToStep() const;   // Milliseconds until the next tick is due, rounded up
+    double stepSeconds() const { return static_cast<double>(stepLength) / frequency; }
+};
+
+#endif
@@ -2,6 +2,7 @@
 #define TYPES_H
 
 #include <cstdint>
+#include <cstddef>
 #include <iostream>
 
 // Struct to hold RGBA values
@@ -27,17 +28,12 @@ enum class Direction : int {
   left = -1         // X-Direction = -1
 };
 
-// Hold the rank for an alien row
-// Rank can be used as an index
-enum class Rank : int {
-  first = 0,
-  second = 1,
-  third = 2,
-  fourth = 3
-};
-
 // Convert a hex color value to an RGB object
 const RGB hexToRGB(std::string hex);
+
+// FNV-1a hash of a block of memory, pass the last result as hash to hash several blocks as one
+const std::uint32_t HASH_SEED = 2166136261u;
+std::uint32_t hashBytes(const void* data, std::size_t bytes, std::uint32_t hash = HASH_SEED);
 std::ostream& operator<<(std::ostream& out, const Direction& direction);
 
 #endif
@@ -0,0 +1,107 @@
+#include "../include/archive.h"
+#include "../include/assetformat.h"
+#include "../include/mappedfile.h"
+#include "../include/profiler.h"
+#include <SDL2/SDL.h>
+#include <string>
+#include <cstring>
+#include <unordered_map>
+#include <iostream>
+
+static_assert(assetformat::PIXEL_FORMAT == SDL_PIXELFORMAT_ARGB8888, "Cooked images must match the texture format");
+
+namespace {
+  MappedFile file;
+  const assetformat::Entry* entries = NULL;   // The index, inside the mapping
+  int entryCount = 0;
+  std::unordered_map<std::string, int> byName;  // Only changes in open and close, so lookups are safe from any thread
+
+  // Does an entry's data, or its spot on its page, lie inside what it points at?
+  bool valid(const assetformat::Entry& entry) {
+    if(entry.name[sizeof(entry.name) - 1] != '\0')
+      return false;
+    switch(entry.kind) {
+      case assetformat::IMAGE:
+        if(entry.pitch < entry.width * 4u || static_cast<std::size_t>(entry.pitch) * entry.height > entry.size)
+          return false;
+        [[fallthrough]];
+      case assetformat::BLOB:
+        return static_cast<std::size_t>(entry.offset) + entry.size <= file.size();
+      case assetformat::SHEET: {
+        if(entry.page >= entryCount || entries[entry.page].kind != assetformat::IMAGE)
+          return false;
+        const assetformat::Entry& page = entries[entry.page];
+        return entry.x + entry.width <= page.width && entry.y + entry.height <= page.height;
+      }
+      default:
+        return false;
+    }
+  }
+}
+
+namespace Archive {
+  bool open(const std::string& path) {
+    PROFILE_SCOPE("Archive::open");
+    close();
+    // Note the format is little-endian, which every platform we build for is
+    assetformat::Header header;
+    if(!file.open(path) || file.size() < sizeof(header)) {
+      std::cout << "Unable to open asset archive: " << path << '\n';
+      return false;
+    }
+    std::memcpy(&header, file.data(), sizeof(header));
+    if(std::memcmp(header.magic, assetformat::MAGIC, sizeof(header.magic)) != 0 || header.version != assetformat::VERSION
+        || header.pixelFormat != assetformat::PIXEL_FORMAT || header.indexOffset % alignof(assetformat::Entry) != 0
+        || header.indexOffset + static_cast<std::size_t>(header.entryCount) * sizeof(assetformat::Entry) > file.size()) {
+      std::cout << "Not a valid asset archive: " << path << '\n';
+      close();
+      return false;
+    }
+
+    // The index is read straight out of the mapping
+    entries = reinterpret_cast<const assetformat::Entry*>(file.data() + header.indexOffset);
+    entryCount = header.entryCount;
+    for(int i = 0; i < entryCount; ++i) {
+      if(!valid(entries[i])) {
+        std::cout << "Asset archive entry " << i << " is corrupt: " << path << '\n';
+        close();
+        return false;
+      }
+      byName[entries[i].name] = i;
+    }
+    return true;
+  }
+
+  void close() {
+    byName.clear();
+    entries = NULL;
+    entryCount = 0;
+    file.close();
+  }
+
+  const assetformat::Entry* find(const std::string& name) {
+    auto found = byName.find(name);
+    return found == byName.end() ? NULL : &entries[found->second];
+  }
+
+  const assetformat::Entry* page(const assetformat::Entry& sheet) {
+    return &entries[sheet.page];
+  }
+
+  unsigned char* data(const assetformat::Entry& entry) {
+    return file.data() + entry.offset;
+  }
+
+  bool matches(const assetformat::Entry& entry, const RGB* transparency) {
+    if(transparency == NULL)
+      return entry.transparency == assetformat::NO_TRANSPARENCY;
+    return entry.transparency == ((static_cast<std::uint32_t>(transparency->r) << 16) | (transparency->g << 8) | transparency->b);
+  }
+
+  // Images with no color key are opaque, so they go up without alpha and draw without blending
+  // The pixels are the same either way, RGB888 just ignores the alpha byte
+  SDL_Surface* surface(const assetformat::Entry& image) {
+    const Uint32 format = (image.transparency == assetformat::NO_TRANSPARENCY) ? SDL_PIXELFORMAT_RGB888 : SDL_PIXELFORMAT_ARGB8888;
+    return SDL_CreateRGBSurfaceWithFormatFrom(data(image), image.width, image.height, 32, static_cast<int>(image.pitch), format);
+  }
+}
@@ -0,0 +1,246 @@
+#include "../include/atlas.h"
+#include "../include/engine.h"
+#include "../include/types.h"
+#include "../include/loader.h"
+#include "../include/archive.h"
+#include <SDL2/SDL.h>
+#include <string>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <filesystem>
+
+namespace Atlas {
+  const int MAX_PAGE_SIZE = 2048;   // Largest page we create, even if the renderer allows more
+  const int PADDING = 1;    // Gap left between packed sheets
+  const int CACHE_VERSION = 1;  // Bump when the cache file layout changes
+
+  // Packed location of a single sheet
+  struct Placement {
+    std::string transparency;
+    std::uintmax_t fileSize = 0;  // Size of the bitmap when it was packed, to detect edits
+    int page = 0;
+    SDL_Rect rect = { 0, 0, 0, 0 };
+  };
+
+  std::vector<TextureHandle> pages;  // Atlas page textures, tracked by the resource cache
+  std::map<std::string, Placement> placements;  // Packed sheets by path
+
+  // Shelf pack the sheets, tallest first, opening new pages as they fill up
+  // Returns the number of pages used, or 0 if a sheet can't fit on any page
+  static int pack(std::vector<Placement>& layout, int pageSize) {
+    std::vector<size_t> order(layout.size());
+    for(size_t i = 0; i < order.size(); ++i)
+      order[i] = i;
+    std::sort(order.begin(), order.end(), [&layout](size_t a, size_t b) { return layout[a].rect.h > layout[b].rect.h; });
+
+    int page = 0;
+    int x = 0;
+    int y = 0;
+    int shelfHeight = 0;
+    for(size_t i : order) {
+      SDL_Rect& rect = layout[i].rect;
+      if(rect.w > pageSize || rect.h > pageSize)
+        return 0;   // Can never fit
+      if(x + rect.w > pageSize) {   // Start a new shelf
+        y += shelfHeight + PADDING;
+        x = 0;
+        shelfHeight = 0;
+      }
+      if(y + rect.h > pageSize) {   // Start a new page
+        page++;
+        x = 0;
+        y = 0;
+        shelfHeight = 0;
+      }
+      rect.x = x;
+      rect.y = y;
+      layout[i].page = page;
+      x += rect.w + PADDING;
+      shelfHeight = std::max(shelfHeight, rect.h);
+    }
+    return page + 1;
+  }
+
+  // Read a cached layout, it only counts if it lists exactly the same sheets, unchanged
+  static bool readCache(const std::string& cachePath, std::vector<Placement>& layout, const std::vector<Sheet>& sheets, int pageSize, int& pageCount) {
+    std::ifstream in(cachePath);
+    std::string magic;
+    int version = 0;
+    int cachedPageSize = 0;
+    size_t count = 0;
+    if(!(in >> magic >> version >> cachedPageSize >> pageCount >> count) || magic != "atlas" || version != CACHE_VERSION || cachedPageSize != pageSize || count != sheets.size())
+      return false;
+
+    for(size_t i = 0; i < count; ++i) {
+      std::string path;
+      Placement entry;
+      if(!(in >> path >> entry.transparency >> entry.fileSize >> entry.page >> entry.rect.x >> entry.rect.y >> entry.rect.w >> entry.rect.h))
+        return false;
+      if(path != sheets[i].path || entry.transparency != sheets[i].transparency || entry.fileSize != layout[i].fileSize || entry.page >= pageCount)
+        return false;
+      layout[i] = entry;
+    }
+    return true;
+  }
+
+  static void writeCache(const std::string& cachePath, const std::vector<Placement>& layout, const std::vector<Sheet>& sheets, int pageSize, int pageCount) {
+    std::ofstream out(cachePath);
+    if(!out.good()) {
+      std::cout << "Unable to write atlas cache: " << cachePath << '\n';
+      return;
+    }
+    out << "atlas " << CACHE_VERSION << ' ' << pageSize << ' ' << pageCount << ' ' << layout.size() << '\n';
+    for(size_t i = 0; i < layout.size(); ++i) {
+      const Placement& entry = layout[i];
+      out << sheets[i].path << ' ' << entry.transparency << ' ' << entry.fileSize << ' ' << entry.page << ' '
+          << entry.rect.x << ' ' << entry.rect.y << ' ' << entry.rect.w << ' ' << entry.rect.h << '\n';
+    }
+  }
+
+  // Copy each sheet onto a transparent page, color key pixels are skipped and stay transparent
+  // Only touches surfaces, so it can run on any thread
+  static SDL_Surface* compose(const std::vector<Sheet>& sheets, const std::vector<SDL_Rect>& rects, int pageSize) {
+    SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormat(0, pageSize, pageSize, 32, SDL_PIXELFORMAT_ARGB8888);
+    if(surface == NULL)
+      return NULL;
+    SDL_FillRect(surface, NULL, 0);
+    for(size_t i = 0; i < sheets.size(); ++i) {
+      SDL_Surface* image = SDL::loadImage(sheets[i].path);
+      if(image == NULL) {
+        SDL_FreeSurface(surface);
+        return NULL;
+      }
+      RGB color = hexToRGB(sheets[i].transparency);
+      SDL::setTransparentColor(image, color.r, color.g, color.b);
+      SDL_SetSurfaceBlendMode(image, SDL_BLENDMODE_NONE);   // Copy pixels as-is rather than blending
+      SDL_Rect destination = rects[i];
+      SDL_BlitSurface(image, NULL, surface, &destination);
+      SDL_FreeSurface(image);
+    }
+    return surface;
+  }
+
+  // Take the layout and pages cooked into the asset archive, if every sheet is in it with the same color key
+  // and the pages fit the renderer
+  static bool readArchive(const std::vector<Sheet>& sheets, int pageSize, std::vector<Placement>& layout, std::vector<const assetformat::Entry*>& cookedPages) {
+    for(size_t i = 0; i < sheets.size(); ++i) {
+      const assetformat::Entry* sheet = Archive::find(sheets[i].path);
+      RGB color = hexToRGB(sheets[i].transparency);
+      if(sheet == NULL || sheet->kind != assetformat::SHEET || !Archive::matches(*sheet, &color))
+        return false;
+      const assetformat::Entry* image = Archive::page(*sheet);
+      if(image->width > pageSize || image->height > pageSize)
+        return false;
+      auto found = std::find(cookedPages.begin(), cookedPages.end(), image);
+      layout[i].transparency = sheets[i].transparency;
+      layout[i].page = static_cast<int>(found - cookedPages.begin());
+      layout[i].rect = { sheet->x, sheet->y, sheet->width, sheet->height };
+      if(found == cookedPages.end())
+        cookedPages.push_back(image);
+    }
+    return true;
+  }
+
+  static bool uploadPage(int page, SDL_Surface* surface) {
+    SDL_Texture* texture = SDL_CreateTextureFromSurface(SDL::renderer, surface);
+    if(texture == NULL)
+      return false;
+    SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+    pages[page] = Resources::adopt("atlas:page" + std::to_string(page), texture);
+    return true;
+  }
+
+  bool build(const std::vector<Sheet>& sheets, std::string cachePath) {
+    destroy();
+
+    // Work out how big a page the renderer can take
+    SDL_RendererInfo info;
+    int pageSize = MAX_PAGE_SIZE;
+    if(SDL_GetRendererInfo(SDL::renderer, &info) == 0 && info.max_texture_width > 0)
+      pageSize = std::min({ pageSize, info.max_texture_width, info.max_texture_height });
+
+    // Pages from the archive go straight up, otherwise each is composed from the bitmaps
+    std::vector<Placement> layout(sheets.size());
+    std::vector<const assetformat::Entry*> cookedPages;
+    const bool cooked = readArchive(sheets, pageSize, layout, cookedPages);
+    bool cached = false;
+    int pageCount = static_cast<int>(cookedPages.size());
+    if(!cooked) {
+      // Gather the size of every sheet
+      for(size_t i = 0; i < sheets.size(); ++i) {
+        std::error_code error;
+        layout[i].transparency = sheets[i].transparency;
+        layout[i].fileSize = std::filesystem::file_size(sheets[i].path, error);
+        if(error) {
+          std::cout << "Unable to find sheet for atlas: " << sheets[i].path << '\n';
+          return false;
+        }
+      }
+
+      // Reuse the cached layout if nothing changed, otherwise pack from scratch
+      cached = readCache(cachePath, layout, sheets, pageSize, pageCount);
+      if(!cached) {
+        for(size_t i = 0; i < sheets.size(); ++i) {
+          layout[i].rect.x = layout[i].rect.y = 0;
+          SDL::readImageSize(sheets[i].path, layout[i].rect.w, layout[i].rect.h);
+        }
+        pageCount = pack(layout, pageSize);
+        if(pageCount == 0) {
+          std::cout << "Sheets are too large to fit in an atlas page\n";
+          return false;
+        }
+      }
+    }
+
+    // Load each page in the background
+    pages.assign(pageCount, TextureHandle());
+    for(int page = 0; page < pageCount; ++page) {
+      auto upload = [page](SDL_Surface* surface) { return uploadPage(page, surface); };
+      if(cooked) {
+        const assetformat::Entry* image = cookedPages[page];
+        Loader::request("atlas page " + std::to_string(page), [image] { return Archive::surface(*image); }, upload);
+        continue;
+      }
+      std::vector<Sheet> onPage;
+      std::vector<SDL_Rect> rects;
+      for(size_t i = 0; i < sheets.size(); ++i) {
+        if(layout[i].page == page) {
+          onPage.push_back(sheets[i]);
+          rects.push_back(layout[i].rect);
+        }
+      }
+      Loader::request("atlas page " + std::to_string(page), [onPage, rects, pageSize] { return compose(onPage, rects, pageSize); }, upload);
+    }
+
+    for(size_t i = 0; i < sheets.size(); ++i)
+      placements[sheets[i].path] = layout[i];
+    if(!cooked && !cached)
+      writeCache(cachePath, layout, sheets, pageSize, pageCount);
+
+    std::cout << "Packed " << sheets.size() << " sheets onto " << pageCount << " atlas page(s)"
+              << (cooked ? " from the asset archive\n" : cached ? " using cached layout\n" : "\n");
+    return true;
+  }
+
+  bool find(const std::string& path, const RGB& transparency, Region& region) {
+    auto found = placements.find(path);
+    if(found == placements.end())
+      return false;
+    RGB packedColor = hexToRGB(found->second.transparency);
+    if(packedColor.r != transparency.r || packedColor.g != transparency.g || packedColor.b != transparency.b)
+      return false;   // Packed with a different color key, can't share it
+    if(!pages[found->second.page])
+      return false;   // Page failed to load
+    region.texture = pages[found->second.page];
+    region.rect = found->second.rect;
+    return true;
+  }
+
+  void destroy() {
+    pages.clear();  // Pages are freed by the resource cache once no sprite uses them
+    placements.clear();
+  }
+}
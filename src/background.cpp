@@ -1,156 +1,243 @@
 #include "../include/background.h"
+#include "../include/profiler.h"
 #include "../include/engine.h"
 #include "../include/settings.h"
-#include <fstream>
+#include "../include/mapformat.h"
+#include "../include/archive.h"
+#include <algorithm>
+#include <cstring>
+#include <cstddef>
 
 // Constructor
 // Create surface and rectangle for background object
 Background::Background(std::string filePath)
   : PATH{ filePath }
 {
-  SDL::tempSurface = SDL::loadImage(PATH);    //load the image
-  texture = SDL::loadTexture(SDL::tempSurface);   //Load the image into a texture
-  SDL::FillRect(rect, 0, 0, settings::SCREEN_WIDTH, settings::SCREEN_HEIGHT);    //Create a rendering rectangle
-}
-
-// Destructor
-// Destroy background texture
-Background::~Background() {
-  SDL_DestroyTexture(texture);  // Destroy the texture object
+  if(!settings::headless) {   // Nothing to draw to in headless mode
+    texture = Resources::load(PATH);    //Load the image into a texture
+  }
 }
 
 // Increment BG by scrollSpeed
 // Account for looping when image moves off of screen
 void Background::scroll() {
-  yOffset += scrollSpeed;   //Increment the y-offset by the scroll speed
-  if(yOffset >= settings::SCREEN_HEIGHT)  //If the image has moved off the screen
+  PROFILE_SCOPE("Background::scroll");
+  prevOffset = yOffset;     //Remember where we were for interpolation
+  yOffset += settings::stretch(scrollSpeed);   //Increment the y-offset by the scroll speed, stretched with the playfield
+  if(yOffset >= settings::fieldHeight) {  //If the image has moved off the playfield
     yOffset = 0;    //Reset the position
-  rect.y = yOffset; //And store the new value in the render rectangle
+    prevOffset -= settings::fieldHeight;  //Keep the previous offset continuous across the wrap
+  }
 }
 
-// Draw the background to the render
+// Add the background to the frame
 // Offset and draw again to simulate motion
-void Background::draw() {
-  SDL_RenderCopy(SDL::renderer, texture, NULL, &rect); // Copy the image to the render
-  rect.y = yOffset - settings::SCREEN_HEIGHT; // Scroll the image down
-  SDL_RenderCopy(SDL::renderer, texture, NULL, &rect); //Copy the image to the render
+void Background::draw(Render::Frame& frame, float alpha) {
+  PROFILE_SCOPE("Background::draw");
+  int offset = prevOffset + static_cast<int>((yOffset - prevOffset) * alpha);  // Interpolate between ticks
+  if(offset < 0)  // Just wrapped, the image repeats every playfield height
+    offset += settings::fieldHeight;
+  if(settings::dirtyRects)  // Held still, a moving backdrop would change every pixel every frame
+    offset = 0;
+  SDL_Rect rect = { 0, offset, settings::fieldWidth, settings::fieldHeight };   // Stretched over the whole playfield
+  frame.addWhole(Layer::background, texture.get(), rect); // Copy the image to the render
+  rect.y = offset - settings::fieldHeight; // Scroll the image down
+  frame.addWhole(Layer::background, texture.get(), rect); //Copy the image to the render
 }
 
-// Create a tilemap object from given image path
-// Load each line from the map file and fill all members
+// Create a tilemap object from the given .tmb map file
+// Map the file and point the tiles straight at its data
 Tilemap::Tilemap(std::string filePath)
   : PATH{filePath}
 {
+  PROFILE_SCOPE("Tilemap::Tilemap");
+  // Use the copy cooked into the asset archive, or map the file, then check the header
+  // Only a blob entry holds the map's bytes, anything else cooked under the name falls back to the file
+  // Note the format is little-endian, which every platform we build for is
+  mapformat::Header header;
+  unsigned char* bytes = NULL;
+  std::size_t size = 0;
+  const assetformat::Entry* cooked = Archive::find(PATH);
+  if(cooked != NULL && cooked->kind == assetformat::BLOB) {
+    bytes = Archive::data(*cooked);
+    size = cooked->size;
+  }
+  else if(file.open(PATH)) {
+    bytes = file.data();
+    size = file.size();
+  }
+  if(bytes == NULL || size < sizeof(header)) {
+    std::cout << "The map did not load.\n";
+    return;
+  }
+  std::memcpy(&header, bytes, sizeof(header));
+  std::size_t tileBytes = static_cast<std::size_t>(header.columns) * header.rows * header.layerCount * (header.bitsPerTile / 8);
+  if(std::memcmp(header.magic, mapformat::MAGIC, sizeof(header.magic)) != 0 || header.version != mapformat::VERSION
+      || (header.bitsPerTile != 8 && header.bitsPerTile != 16) || header.sheetId >= mapformat::SHEET_COUNT
+      || header.tileWidth == 0 || header.tileHeight == 0 || header.columns == 0 || header.rows == 0
+      || header.dataOffset + tileBytes > size) {
+    std::cout << "The map file is not a valid tilemap: " << PATH << '\n';
+    file.close();
+    return;
+  }
+
+  // Tiles are read straight out of the mapping, no parsing or copying
+  tiles = bytes + header.dataOffset;
+  bitsPerTile = header.bitsPerTile;
+  mapLayers = header.layerCount;
+  mapCol = header.columns;
+  mapRow = header.rows;
+  tileWidth = header.tileWidth;
+  tileHeight = header.tileHeight;
+
   // Set up the texture
-  // Load the image onto a transoarent surface
-  SDL::tempSurface = SDL::loadImage("graphics/tiles.bmp");
-  SDL::tempSurface = SDL::setTransparentColor(SDL::tempSurface, 0, 255, 0);
-  // Load the surface onto a texture
-  texture = SDL::loadTexture(SDL::tempSurface);
+  const mapformat::Sheet& sheet = mapformat::SHEETS[header.sheetId];
+  texture = Resources::load(sheet.path, hexToRGB(sheet.transparency));
+  sheetWidth = texture.getWidth();
+  sheetHeight = texture.getHeight();
+
+  // Create the layer to bake the tiles onto
+  SDL::FillRect(rectLayer, 0, 0, mapCol * tileWidth, mapRow * tileHeight);
+  if(SDL_RenderTargetSupported(SDL::renderer)) {
+    SDL_Texture* target = SDL_CreateTexture(SDL::renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET, rectLayer.w, rectLayer.h);
+    if(target == NULL) {
+      std::cout << "Unable to create tilemap layer, drawing tiles individually\n";
+    }
+    else {
+      SDL_SetTextureBlendMode(target, SDL_BLENDMODE_BLEND);  // Empty tiles stay see-through
+      layer = Resources::adopt(PATH + ":layer", target);
+    }
+  }
+  markDirty(rectLayer);   // Bake the whole map on the first draw
+}
 
-  // Get the tile data  
-  // Load the map file
-  std::ifstream in("graphics/map.map");
+// Textures are released with their handles, tiles with the mapping
+Tilemap::~Tilemap(){
+  tiles = NULL;
+}
 
-  if(!in.good())
-    std::cout << "The map did not load.\n";
+// Visit each tile that overlaps the region, layer by layer
+template <typename Copy>
+void Tilemap::forEachTile(const SDL_Rect& region, Copy copy) const {
+  PROFILE_SCOPE("Tilemap::forEachTile");
+  // Only walk the rows and columns the region covers
+  int firstCol = region.x / tileWidth;
+  int firstRow = region.y / tileHeight;
+  int lastCol = std::min(mapCol, (region.x + region.w + tileWidth - 1) / tileWidth);
+  int lastRow = std::min(mapRow, (region.y + region.h + tileHeight - 1) / tileHeight);
+
+  for(int mapLayer = 0; mapLayer < mapLayers; mapLayer++) {
+    for(int row = firstRow; row < lastRow; row++) {
+      for(int col = firstCol; col < lastCol; col++) {
+        int frame = getTile(col, row, mapLayer);    // Get the frame id of the current tile
+        if(frame > 0) {   // Grab the tile if we have a Frame ID
+          // Calculate x and y location of tile on sheet
+          int rawBytes = ((frame -1) * tileWidth);
+          int xSource = rawBytes % sheetWidth;
+          int ySource = (rawBytes / sheetWidth) * tileHeight;
+
+          // Initialize source rectangle on the texture sheet
+          SDL_Rect rectSource;
+          SDL::FillRect(rectSource, xSource, ySource, tileWidth, tileHeight);
+
+          // Calculate x and y position to render on screen
+          int xDest = col * tileWidth;
+          int yDest = row * tileHeight;
+
+          // Initialize the destination rectangle for rendering
+          SDL_Rect rectPlacement;
+          SDL::FillRect(rectPlacement, xDest, yDest, tileWidth, tileHeight);
+
+          // Copy the tile
+          copy(rectSource, rectPlacement);
+        }     // End frame rendering
+      }   // End column rendering
+    } // End row rendering
+  } // End layer rendering
+}
 
-  std::string buffer;
-
-  // Get the line that says 'destWidth'
-  std::getline(in, buffer, ' ');
-  // Get the width value
-  std::getline(in, buffer, '\n');
-  sheetWidth = std::atoi(buffer.c_str());
-
-  // Get the line that says 'destHeight'
-  std::getline(in, buffer, ' ');
-  // Get the height value
-  std::getline(in, buffer, '\n');
-  sheetHeight = std::atoi(buffer.c_str());
-
-  // Get the line that says 'mapWidth'
-  std::getline(in, buffer, ' ');
-  // Get the mapWidth value
-  std::getline(in, buffer, '\n');
-  mapCol = std::atoi(buffer.c_str());
-
-  // Get the line that says 'mapHeight'
-  std::getline(in, buffer, ' ');
-  // Get the mapHeight value
-  std::getline(in, buffer, '\n');
-  mapRow = std::atoi(buffer.c_str());
-
-  // Get the line that says 'tile_width'
-  std::getline(in, buffer, ' ');
-  // Get the tile_width value
-  std::getline(in, buffer, '\n');
-  tileWidth = std::atoi(buffer.c_str());
-
-  // Get the line that says 'tile_height'
-  std::getline(in, buffer, ' ');
-  // Get the tile_height value
-  std::getline(in, buffer, '\n');
-  tileHeight = std::atoi(buffer.c_str());
-  
-  // Set up the array to hold the tiles
-  tiles = new int[mapCol * mapRow];
-
-  // Get the line that says 'layer1'
-  std::getline(in, buffer, '\n');
-
-  int i = 0;    // array index
-  for(int row = 0; row < mapRow; row++) {
-    for(int col = 0; col < mapCol; col++) {
-      char delim = ','; // comma delimits between frames
-      if(col == mapCol - 1) // Unless last frame in row, then set to new line
-        delim = '\n';
-      std::getline(in, buffer, delim);  // Get the Frame ID
-      int data = std::atoi(buffer.c_str());     // Convert it to an integer
-      tiles[i] = data;      // And store the Frame ID at the tile's index
-      i++;
-    }   // End column loop
-  } // End row loop
-
-  in.close();
+// Bake any changed tiles onto the layer
+void Tilemap::prepare(){
+  if(tiles == NULL || !layer)
+    return;
+  if(SDL::targetsLost) {  // The renderer threw away our layer contents
+    SDL::targetsLost = false;
+    markDirty(rectLayer);
+  }
+  if(isDirty) {
+    Render::invalidate(Render::stretch(dirty));  // The layer texture changes under the same copy, so tell the renderer
+    bake();
+  }
 }
 
-// Destroy all textures and tiles
-Tilemap::~Tilemap(){
-  SDL_DestroyTexture(texture);
-  if(tiles != NULL) {
-    delete[] tiles;
-    tiles = NULL;
+// Add the tilemap to the frame
+// The baked layer goes out as a single copy
+void Tilemap::draw(Render::Frame& frame){
+  PROFILE_SCOPE("Tilemap::draw");
+  if(tiles == NULL)   // Map failed to load
+    return;
+  if(!layer) {   // No render target, draw tile by tile
+    SDL_Texture* sheet = texture.get();
+    forEachTile(rectLayer, [&](const SDL_Rect& source, const SDL_Rect& placement) {
+      frame.add(Layer::tiles, sheet, source, Render::stretch(placement));
+    });
+    return;
+  }
+  frame.addWhole(Layer::tiles, layer.get(), Render::stretch(rectLayer));  // The map covers the same share of a stretched playfield
+}
+
+// Get the frame id of a single tile
+int Tilemap::getTile(int col, int row, int mapLayer) const {
+  std::size_t index = (static_cast<std::size_t>(mapLayer) * mapRow + row) * mapCol + col;
+  if(bitsPerTile == 8)
+    return tiles[index];
+  return tiles[index * 2] | (tiles[index * 2 + 1] << 8);
+}
+
+// Change the frame id of a single tile
+// The mapping is private, so edits never reach the file on disk
+void Tilemap::setTile(int col, int row, int frame, int mapLayer) {
+  if(col < 0 || col >= mapCol || row < 0 || row >= mapRow || mapLayer < 0 || mapLayer >= mapLayers || getTile(col, row, mapLayer) == frame)
+    return;   // Off the map or nothing changed
+  std::size_t index = (static_cast<std::size_t>(mapLayer) * mapRow + row) * mapCol + col;
+  if(bitsPerTile == 8) {
+    tiles[index] = static_cast<unsigned char>(frame);
+  }
+  else {
+    tiles[index * 2] = static_cast<unsigned char>(frame & 0xff);
+    tiles[index * 2 + 1] = static_cast<unsigned char>(frame >> 8);
+  }
+  SDL_Rect tile = { col * tileWidth, row * tileHeight, tileWidth, tileHeight };
+  markDirty(tile);
+}
+
+void Tilemap::markDirty(const SDL_Rect& region) {
+  if(!isDirty) {
+    dirty = region;
+    isDirty = true;
+  }
+  else {
+    SDL_UnionRect(&dirty, &region, &dirty);
   }
 }
 
-// Draw the tilemap to the render
-void Tilemap::draw(){
-  // Draw a layer
-  for(int row = 0; row < mapRow; row++) {
-    for(int col = 0; col < mapCol; col++) {
-      int frame = tiles[row*mapCol+col];    // Get the frame id of the current tile
-      if(frame > 0) {   // Grab the tile if we have a Frame ID
-        // Calculate x and y location of tile on sheet
-        int rawBytes = ((frame -1) * tileWidth);
-        int xSource = rawBytes % sheetWidth;
-        int ySource = (rawBytes / sheetWidth) * tileHeight;
-
-        // Initialize source rectangle on the texture sheet
-        SDL::FillRect(rectSource, xSource, ySource, tileWidth, tileHeight);
-
-        // Calculate x and y position to render on screen
-        int xDest = col * tileWidth;
-        int yDest = row * tileHeight;
-
-        // Initialize the destination rectangle for rendering
-        SDL::FillRect(rectPlacement, xDest, yDest, tileWidth, tileHeight);
-
-        // Copy the tile to the renderer
-        SDL_RenderCopy(SDL::renderer, texture, &rectSource, &rectPlacement);
-      }     // End frame rendering
-    }   // End column rendering
-  } // End row rendering  
+// Clear the dirty region of the layer and redraw the tiles inside it
+void Tilemap::bake() {
+  PROFILE_SCOPE("Tilemap::bake");
+  SDL_SetRenderTarget(SDL::renderer, layer.get());
+
+  // Wipe the region to fully transparent
+  SDL_SetRenderDrawBlendMode(SDL::renderer, SDL_BLENDMODE_NONE);
+  SDL_SetRenderDrawColor(SDL::renderer, 0, 0, 0, 0);
+  SDL_RenderFillRect(SDL::renderer, &dirty);
+  SDL_SetRenderDrawColor(SDL::renderer, 0, 0, 0, 255);
+
+  forEachTile(dirty, [this](const SDL_Rect& source, const SDL_Rect& placement) {
+    SDL_RenderCopy(SDL::renderer, texture.get(), &source, &placement);
+  });
+
+  SDL_SetRenderTarget(SDL::renderer, NULL);
+  isDirty = false;
 }
 
 // operator<< overload for debug purpopses
@@ -158,8 +245,7 @@ void Tilemap::draw(){
 std::ostream& operator<<(std::ostream& out, const Background& background) {
   out << "Background:\n"
     << "Path: \'" << background.PATH << "\'\n"
-    << "Texture Ptr: " << background.texture << '\n'
-    << "Rectangle (x,y,w,h): " << static_cast<int>(background.rect.x) << ", " << static_cast<int>(background.rect.y) << ", " << static_cast<int>(background.rect.w) << ", " << static_cast<int>(background.rect.h) << '\n'
+    << "Texture Ptr: " << background.texture.get() << '\n'
     << "Scrolling: (y + " << background.yOffset << ") @ " << background.scrollSpeed << " per frame";
 
   return out;
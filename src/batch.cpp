@@ -0,0 +1,83 @@
+#include "../include/batch.h"
+#include "../include/profiler.h"
+#include "../include/engine.h"
+#include <SDL2/SDL.h>
+#include <vector>
+#include <iostream>
+
+long long SpriteBatch::spritesDrawn = 0;
+long long SpriteBatch::drawCalls = 0;
+
+// Start a new batch, dropping anything left unsubmitted
+void SpriteBatch::begin(SDL_Texture* sheet) {
+  texture = sheet;
+  vertices.clear();
+  int w = 1;
+  int h = 1;
+  if(texture != NULL)
+    SDL_QueryTexture(texture, NULL, NULL, &w, &h);  // Get the dimensions of the texture
+  textureWidth = static_cast<float>(w);
+  textureHeight = static_cast<float>(h);
+}
+
+// Queue a quad copying source on the texture to placement on the screen
+void SpriteBatch::add(const SDL_Rect& source, const SDL_Rect& placement) {
+  // Corners on screen
+  float left = static_cast<float>(placement.x);
+  float top = static_cast<float>(placement.y);
+  float right = static_cast<float>(placement.x + placement.w);
+  float bottom = static_cast<float>(placement.y + placement.h);
+
+  // Corners on the texture, normalized
+  float u0 = source.x / textureWidth;
+  float v0 = source.y / textureHeight;
+  float u1 = (source.x + source.w) / textureWidth;
+  float v1 = (source.y + source.h) / textureHeight;
+
+  const SDL_Color white = { 255, 255, 255, 255 };
+  vertices.push_back({ { left, top }, white, { u0, v0 } });
+  vertices.push_back({ { right, top }, white, { u1, v0 } });
+  vertices.push_back({ { left, bottom }, white, { u0, v1 } });
+  vertices.push_back({ { right, bottom }, white, { u1, v1 } });
+}
+
+// Submit the whole batch with one draw call
+void SpriteBatch::flush() {
+  PROFILE_SCOPE("SpriteBatch::flush");
+  int quads = size();
+  if(quads == 0)
+    return;
+
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+  // Extend the shared index pattern if this is the biggest batch yet
+  for(int quad = static_cast<int>(indices.size()) / 6; quad < quads; ++quad) {
+    int corner = quad * 4;
+    indices.insert(indices.end(), { corner, corner + 1, corner + 2, corner + 2, corner + 1, corner + 3 });
+  }
+  SDL_RenderGeometry(SDL::renderer, texture, vertices.data(), static_cast<int>(vertices.size()), indices.data(), quads * 6);
+  drawCalls++;
+#else
+  // Older SDL has no geometry API, fall back to one copy per quad
+  for(int quad = 0; quad < quads; ++quad) {
+    const SDL_Vertex* corner = &vertices[quad * 4];
+    SDL_Rect source = {
+      static_cast<int>(corner[0].tex_coord.x * textureWidth), static_cast<int>(corner[0].tex_coord.y * textureHeight),
+      static_cast<int>((corner[3].tex_coord.x - corner[0].tex_coord.x) * textureWidth), static_cast<int>((corner[3].tex_coord.y - corner[0].tex_coord.y) * textureHeight)
+    };
+    SDL_Rect placement = {
+      static_cast<int>(corner[0].position.x), static_cast<int>(corner[0].position.y),
+      static_cast<int>(corner[3].position.x - corner[0].position.x), static_cast<int>(corner[3].position.y - corner[0].position.y)
+    };
+    SDL_RenderCopy(SDL::renderer, texture, &source, &placement);
+    drawCalls++;
+  }
+#endif
+  spritesDrawn += quads;
+  vertices.clear();
+}
+
+// Print totals for every batch submitted so far
+void SpriteBatch::report(std::ostream& out) {
+  out << "Sprite batching: " << spritesDrawn << " sprites in " << drawCalls << " draw calls ("
+      << spritesDrawn - drawCalls << " draw calls saved)\n";
+}
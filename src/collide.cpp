@@ -0,0 +1,120 @@
+#include "../include/collide.h"
+#include <SDL2/SDL.h>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <iostream>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+  #define COLLIDE_X86
+  #include <immintrin.h>
+  #if defined(__GNUC__) || defined(__clang__)
+    #define COLLIDE_AVX2 __attribute__((target("avx2")))
+  #else
+    #define COLLIDE_AVX2    // MSVC emits AVX2 intrinsics without a flag
+  #endif
+#endif
+
+namespace {
+  typedef void (*Kernel)(const SDL_Rect& box, const int* x, const int* y, int width, int height, int count, std::uint64_t* hits);
+
+  // Boxes overlap when each one starts before the other ends, on both axes
+  // Every kernel works on the same rearranged form: box.x - width < x < box.x + box.w, likewise for y
+  // Edges that only touch don't count
+
+  // Test the boxes from first on one at a time
+  void scalarRange(const SDL_Rect& box, const int* x, const int* y, int width, int height, int first, int count, std::uint64_t* hits) {
+    const int left = box.x - width;
+    const int right = box.x + box.w;
+    const int top = box.y - height;
+    const int bottom = box.y + box.h;
+    for(int i = first; i < count; ++i) {
+      std::uint64_t hit = (x[i] > left) & (x[i] < right) & (y[i] > top) & (y[i] < bottom);
+      hits[i / 64] |= hit << (i % 64);
+    }
+  }
+
+  void scalarKernel(const SDL_Rect& box, const int* x, const int* y, int width, int height, int count, std::uint64_t* hits) {
+    scalarRange(box, x, y, width, height, 0, count, hits);
+  }
+
+#ifdef COLLIDE_X86
+  // Four boxes per step
+  void sse2Kernel(const SDL_Rect& box, const int* x, const int* y, int width, int height, int count, std::uint64_t* hits) {
+    const __m128i left = _mm_set1_epi32(box.x - width);
+    const __m128i right = _mm_set1_epi32(box.x + box.w);
+    const __m128i top = _mm_set1_epi32(box.y - height);
+    const __m128i bottom = _mm_set1_epi32(box.y + box.h);
+    int i = 0;
+    for(; i + 4 <= count; i += 4) {
+      __m128i xs = _mm_loadu_si128(reinterpret_cast<const __m128i*>(x + i));
+      __m128i ys = _mm_loadu_si128(reinterpret_cast<const __m128i*>(y + i));
+      __m128i overlap = _mm_and_si128(_mm_and_si128(_mm_cmpgt_epi32(xs, left), _mm_cmplt_epi32(xs, right)),
+                                      _mm_and_si128(_mm_cmpgt_epi32(ys, top), _mm_cmplt_epi32(ys, bottom)));
+      std::uint64_t lanes = static_cast<unsigned>(_mm_movemask_ps(_mm_castsi128_ps(overlap)));
+      hits[i / 64] |= lanes << (i % 64);
+    }
+    scalarRange(box, x, y, width, height, i, count, hits);   // Leftover boxes
+  }
+
+  // Eight boxes per step
+  COLLIDE_AVX2 void avx2Kernel(const SDL_Rect& box, const int* x, const int* y, int width, int height, int count, std::uint64_t* hits) {
+    const __m256i left = _mm256_set1_epi32(box.x - width);
+    const __m256i right = _mm256_set1_epi32(box.x + box.w);
+    const __m256i top = _mm256_set1_epi32(box.y - height);
+    const __m256i bottom = _mm256_set1_epi32(box.y + box.h);
+    int i = 0;
+    for(; i + 8 <= count; i += 8) {
+      __m256i xs = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(x + i));
+      __m256i ys = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(y + i));
+      __m256i overlap = _mm256_and_si256(_mm256_and_si256(_mm256_cmpgt_epi32(xs, left), _mm256_cmpgt_epi32(right, xs)),
+                                         _mm256_and_si256(_mm256_cmpgt_epi32(ys, top), _mm256_cmpgt_epi32(bottom, ys)));
+      std::uint64_t lanes = static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(overlap)));
+      hits[i / 64] |= lanes << (i % 64);
+    }
+    scalarRange(box, x, y, width, height, i, count, hits);   // Leftover boxes
+  }
+#endif
+
+  Kernel kernel = NULL;
+  const char* name = "none";
+  std::once_flag selected;  // Worker threads can make the first call, so pick the kernel exactly once
+
+  // Pick the widest kernel this CPU runs
+  void selectKernel() {
+    kernel = scalarKernel;
+    name = "scalar";
+#ifdef COLLIDE_X86
+    if(SDL_HasAVX2()) {
+      kernel = avx2Kernel;
+      name = "AVX2";
+    }
+    else if(SDL_HasSSE2()) {
+      kernel = sse2Kernel;
+      name = "SSE2";
+    }
+#endif
+  }
+}
+
+namespace Collide {
+  bool overlaps(const SDL_Rect& box, const int* x, const int* y, int width, int height, int count, std::uint64_t* hits) {
+    std::call_once(selected, selectKernel);
+    const int words = maskWords(count);
+    std::memset(hits, 0, words * sizeof(std::uint64_t));
+    kernel(box, x, y, width, height, count, hits);
+    std::uint64_t any = 0;
+    for(int i = 0; i < words; ++i)
+      any |= hits[i];
+    return any != 0;
+  }
+
+  const char* kernelName() {
+    std::call_once(selected, selectKernel);
+    return name;
+  }
+
+  void report(std::ostream& out) {
+    out << "Collision kernel: " << kernelName() << '\n';
+  }
+}
@@ -0,0 +1,123 @@
+#include "../include/ecs.h"
+#include <vector>
+#include <cstdint>
+#include <iostream>
+
+// Archetypes are few and never removed, a linear search is plenty
+int World::findArchetype(ComponentMask mask) {
+  for(int i = 0; i < static_cast<int>(archetypes.size()); ++i) {
+    if(archetypes[i].mask == mask)
+      return i;
+  }
+  archetypes.emplace_back();
+  archetypes.back().mask = mask;
+  return static_cast<int>(archetypes.size()) - 1;
+}
+
+// Take a free slot, or a new one if none are free, and add a row to the entity's archetype
+Entity World::create(ComponentMask mask) {
+  int slot = freeHead;
+  if(slot != NO_SLOT) {
+    freeHead = records[slot].row;
+  }
+  else {
+    slot = static_cast<int>(records.size());
+    records.emplace_back();
+  }
+  Record& record = records[slot];
+  record.generation++;
+  record.archetype = findArchetype(mask);
+
+  Archetype& archetype = archetypes[record.archetype];
+  record.row = archetype.size();
+  Entity entity = { static_cast<std::uint32_t>(slot), record.generation };
+  archetype.entities.push_back(entity);
+  if(mask & TRANSFORM)
+    archetype.transforms.emplace_back();
+  if(mask & SPRITE)
+    archetype.sprites.emplace_back();
+  if(mask & ANIMATION)
+    archetype.animations.emplace_back();
+  if(mask & COLLIDER)
+    archetype.colliders.emplace_back();
+  if(mask & LIFETIME)
+    archetype.lifetimes.emplace_back();
+  live++;
+  return entity;
+}
+
+// Move the last row of a column into the hole and drop the last row
+template <typename Component>
+static void removeRow(std::vector<Component>& column, int row) {
+  column[row] = column.back();
+  column.pop_back();
+}
+
+void World::destroy(Entity entity) {
+  if(!isAlive(entity))
+    return;
+  Record& record = records[entity.index];
+  Archetype& archetype = archetypes[record.archetype];
+  const int row = record.row;
+
+  // The last entity takes over the row
+  const Entity moved = archetype.entities.back();
+  records[moved.index].row = row;
+  removeRow(archetype.entities, row);
+  if(archetype.mask & TRANSFORM)
+    removeRow(archetype.transforms, row);
+  if(archetype.mask & SPRITE)
+    removeRow(archetype.sprites, row);
+  if(archetype.mask & ANIMATION)
+    removeRow(archetype.animations, row);
+  if(archetype.mask & COLLIDER)
+    removeRow(archetype.colliders, row);
+  if(archetype.mask & LIFETIME)
+    removeRow(archetype.lifetimes, row);
+
+  // Free the slot, the generation moves on when it is reused
+  record.archetype = NO_SLOT;
+  record.row = freeHead;
+  freeHead = static_cast<int>(entity.index);
+  live--;
+}
+
+// Empty every archetype and free every slot, keeping generations so old handles stay dead
+void World::clear() {
+  for(Archetype& archetype : archetypes) {
+    ComponentMask mask = archetype.mask;
+    archetype = Archetype();
+    archetype.mask = mask;
+  }
+  freeHead = NO_SLOT;
+  for(int slot = static_cast<int>(records.size()) - 1; slot >= 0; --slot) {
+    records[slot].archetype = NO_SLOT;
+    records[slot].row = freeHead;
+    freeHead = slot;
+  }
+  live = 0;
+}
+
+bool World::isAlive(Entity entity) const {
+  return entity.index < records.size() && records[entity.index].archetype != NO_SLOT
+      && records[entity.index].generation == entity.generation;
+}
+
+// Print each archetype
+std::ostream& operator<<(std::ostream& out, const World& world) {
+  static const char* componentNames[] = { "Transform", "Sprite", "Animation", "Collider", "Lifetime" };
+
+  out << "World: " << world.live << " entities in " << world.archetypes.size() << " archetypes\n";
+  for(const Archetype& archetype : world.archetypes) {
+    out << "*Archetype [";
+    const char* separator = "";
+    for(int bit = 0; bit < 5; ++bit) {
+      if(archetype.mask & (1 << bit)) {
+        out << separator << componentNames[bit];
+        separator = ", ";
+      }
+    }
+    out << "]: " << archetype.size() << " entities\n";
+  }
+  return out;
+}
@@ -0,0 +1,76 @@
+#include "../include/effects.h"
+#include "../include/sprite.h"
+#include "../include/systems.h"
+#include <string>
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+namespace {
+  // How each type looks and plays, shared by every effect of that type
+  struct Sheet {
+    std::string path;
+    std::string transparency;
+    int frames;       // Frames on the strip
+    int frameDelay;   // Ticks to hold each frame for
+    Sprite sprite;    // First frame of the strip
+  };
+
+  // Effect sheets, indexed by EffectType
+  Sheet sheets[int(EffectType::MAX_TYPES)] = {
+    { "graphics/explosion.bmp", "#000000", 8, 1, {} },   // explosion
+    { "graphics/explosion.bmp", "#000000", 8, 3, {} }    // playerHit
+  };
+
+  std::vector<Entity> removed;  // Effects to destroy once clear() has found them all
+}
+
+namespace Effects {
+  // Types sharing a sheet share its texture through the atlas or the resource cache
+  bool init() {
+    for(Sheet& sheet : sheets) {
+      sheet.sprite = Sprites::load(sheet.path, sheet.frames, sheet.transparency);
+      if(sheet.sprite.source.w == 0) {
+        std::cout << "Failed to load effect sheet " << sheet.path << '\n';
+        return false;
+      }
+      sheet.sprite.layer = Layer::effects;
+    }
+    return true;
+  }
+
+  // The sheets themselves are released with the rest by Sprites::release()
+  void destroy() {
+    for(Sheet& sheet : sheets)
+      sheet.sprite = Sprite();
+  }
+
+  // The lifetime runs out right as the last frame finishes
+  Entity spawn(World& world, EffectType type, const Point2d& center, int delay) {
+    const Sheet& sheet = sheets[int(type)];
+    Entity effect = world.create<Transform, Sprite, Animation, Lifetime>();
+    Transform* transform = world.get<Transform>(effect);
+    transform->position = { center.x - sheet.sprite.source.w / 2, center.y - sheet.sprite.source.h / 2 };
+    transform->previous = transform->position;
+    Sprite* sprite = world.get<Sprite>(effect);
+    *sprite = sheet.sprite;
+    Lifetime* lifetime = world.get<Lifetime>(effect);
+    lifetime->delay = std::max(delay, 0);
+    lifetime->ticks = sheet.frames * (sheet.frameDelay + 1);
+    sprite->visible = (lifetime->delay == 0);
+    Animation* animation = world.get<Animation>(effect);
+    animation->frames = sheet.frames;
+    animation->frameDelay = sheet.frameDelay;
+    animation->counter = -lifetime->delay;  // Hold the first frame until the effect shows
+    return effect;
+  }
+
+  void clear(World& world) {
+    removed.clear();
+    world.each<Lifetime>([](Entity entity, Lifetime&) {
+      removed.push_back(entity);
+    });
+    for(Entity entity : removed)
+      world.destroy(entity);
+  }
+}
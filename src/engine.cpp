@@ -1,18 +1,23 @@
 #include "../include/engine.h"
 #include "../include/settings.h"
+#include "../include/resources.h"
+#include "../include/random.h"
+#include "../include/archive.h"
 #include <SDL2/SDL.h>
 #include <string>
 #include <iostream>
-#include <ctime>
+#include <fstream>
+#include <cstdint>
 
 namespace SDL {
   // Declare global SDL objects
   SDL_Window* gameWindow = NULL;
   SDL_Renderer* renderer = NULL;
-  SDL_Surface* tempSurface = NULL;
   bool alien_init = false;
   bool bullet_init = false;
   bool static_init = false;         // Track static class variable initialization state to be used as an invariant
+  bool targetsLost = false;         // Set when the renderer discards render target contents
+  bool windowExposed = false;       // Set when the window contents have to be drawn again in full
 
   
   // Check if SDL is running
@@ -23,6 +28,10 @@ namespace SDL {
     while(SDL_PollEvent(&event)) {
       if(event.type == SDL_QUIT)
         running = false;
+      if(event.type == SDL_RENDER_TARGETS_RESET || event.type == SDL_RENDER_DEVICE_RESET)
+        targetsLost = true;   // Anything baked into a target texture has to be redrawn
+      if(event.type == SDL_WINDOWEVENT && event.window.event == SDL_WINDOWEVENT_EXPOSED)
+        windowExposed = true;   // Partial redraws can't rely on what was on screen before
     }
 
     return running;
@@ -30,13 +39,13 @@ namespace SDL {
 
   SDL_Surface* loadImage(std::string path) {
     //Load image at specified path
-    tempSurface = SDL_LoadBMP(path.c_str());
+    SDL_Surface* surface = SDL_LoadBMP(path.c_str());
 
-    if( tempSurface == NULL ) {
+    if( surface == NULL ) {
         printf("Unable to load image at path: %s\n", path.c_str());
     }
 
-    return tempSurface;
+    return surface;
   }//end loadImage
 
   SDL_Texture* loadTexture(SDL_Surface* tempSurface) {
@@ -62,6 +71,43 @@ namespace SDL {
     return surface;
   }//End setTransparent Color
 
+  // Get the size of a bitmap without decoding it, from the asset archive if it was cooked into it
+  // Used in headless mode where there is no renderer to create textures with
+  bool readImageSize(std::string path, int& width, int& height) {
+    if(const assetformat::Entry* cooked = Archive::find(path)) {
+      width = cooked->width;
+      height = cooked->height;
+      return true;
+    }
+    std::ifstream in(path, std::ios::binary);
+    unsigned char header[26];   // File header plus the start of the info header
+    if(!in.read(reinterpret_cast<char*>(header), sizeof(header)) || header[0] != 'B' || header[1] != 'M') {
+      printf("Unable to read image header at path: %s\n", path.c_str());
+      width = height = 0;
+      return false;
+    }
+
+    // Read a little-endian value out of the header
+    auto readLE = [&header](int offset, int bytes) {
+      std::uint32_t value = 0;
+      for(int i = bytes - 1; i >= 0; --i)
+        value = (value << 8) | header[offset + i];
+      return value;
+    };
+
+    if(readLE(14, 4) == 12) {   // Old OS/2 header stores 16-bit dimensions
+      width = static_cast<std::int16_t>(readLE(18, 2));
+      height = static_cast<std::int16_t>(readLE(20, 2));
+    }
+    else {
+      width = static_cast<std::int32_t>(readLE(18, 4));
+      height = static_cast<std::int32_t>(readLE(22, 4));
+    }
+    if(height < 0)  // Negative height marks a top-down bitmap
+      height = -height;
+    return true;
+  }
+
   void FillRect(SDL_Rect &rect, int x, int y, int width, int height) {
     //Initialize the rectangle
     rect.x = x;         //initial x position of upper left corner
@@ -71,6 +117,16 @@ namespace SDL {
   }//end rectangle initializing
 
   bool Init() {
+    // Headless runs only need the timer, there is no window or renderer
+    if(settings::headless) {
+      if(SDL_Init(SDL_INIT_TIMER) < 0) {
+        std::cout << "Failed to initialize SDL!\n";
+        return false;
+      }
+      gameRandom.seed(settings::seed);
+      return true;
+    }
+
     // Initialize SDL
     // Create the renderer and the window
     if(SDL_Init(SDL_INIT_EVERYTHING) < 0) { // Initialize all SDL objects
@@ -79,17 +135,25 @@ namespace SDL {
     }
 
     gameWindow = SDL_CreateWindow("SDL Invaders", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, settings::SCREEN_WIDTH, settings::SCREEN_HEIGHT, SDL_WINDOW_SHOWN);
-    renderer = SDL_CreateRenderer(gameWindow, -1, 0);
+    Uint32 rendererFlags = SDL_RENDERER_TARGETTEXTURE;  // Allow drawing onto textures for pre-baked layers
+    if(settings::vsync)   // Optionally present in step with the display
+      rendererFlags |= SDL_RENDERER_PRESENTVSYNC;
+    if(settings::dirtyRects)  // Draw straight into the window surface, so parts of it can be updated on their own
+      renderer = SDL_CreateSoftwareRenderer(SDL_GetWindowSurface(gameWindow));
+    else
+      renderer = SDL_CreateRenderer(gameWindow, -1, rendererFlags);
+    Resources::setBudget(static_cast<std::size_t>(settings::textureBudgetMB) * 1024 * 1024);
     
-    std::srand(std::time(0)); // Seed the random number generator for object creation
+    gameRandom.seed(settings::seed); // Seed the game's random numbers, replays bring their own seed
     return true;
   }
 
   void CloseShop() {
     //Destroy all objects
+    Resources::shutdown();  // Textures have to go before the renderer that owns them
+    Archive::close();   // Nothing points into the archive once the objects and textures are gone
     SDL_DestroyRenderer(renderer);
     SDL_DestroyWindow(gameWindow);
-    tempSurface = NULL;
     gameWindow = NULL;
     renderer = NULL;
     SDL_Quit(); //Quit the program
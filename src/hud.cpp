@@ -0,0 +1,155 @@
+#include "../include/hud.h"
+#include "../include/engine.h"
+#include "../include/settings.h"
+#include "../include/resources.h"
+#include "../include/profiler.h"
+#include <SDL2/SDL.h>
+#include <cctype>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <iostream>
+
+namespace {
+  const int GLYPH_WIDTH = 5;    // Font pixels
+  const int GLYPH_HEIGHT = 7;
+  const int ADVANCE = GLYPH_WIDTH + 1;  // Glyphs sit this far apart, on the sheet and on screen
+  const int SCALE = 3;    // Screen pixels per font pixel
+  const int MARGIN = 16;  // Gap between the text and the edge of the screen
+  const Uint32 COLOR = 0xffffffff;  // ARGB
+
+  // Characters the font has, in the order they sit on the sheet
+  const char CHARACTERS[] = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ:-";
+  const int CHARACTER_COUNT = sizeof(CHARACTERS) - 1;
+
+  // One row per byte, top row first, the lowest 5 bits left to right
+  const std::uint8_t GLYPHS[CHARACTER_COUNT][GLYPH_HEIGHT] = {
+    { 0x0e, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0e },   // 0
+    { 0x04, 0x0c, 0x04, 0x04, 0x04, 0x04, 0x0e },   // 1
+    { 0x0e, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1f },   // 2
+    { 0x1f, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0e },   // 3
+    { 0x02, 0x06, 0x0a, 0x12, 0x1f, 0x02, 0x02 },   // 4
+    { 0x1f, 0x10, 0x1e, 0x01, 0x01, 0x11, 0x0e },   // 5
+    { 0x06, 0x08, 0x10, 0x1e, 0x11, 0x11, 0x0e },   // 6
+    { 0x1f, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08 },   // 7
+    { 0x0e, 0x11, 0x11, 0x0e, 0x11, 0x11, 0x0e },   // 8
+    { 0x0e, 0x11, 0x11, 0x0f, 0x01, 0x02, 0x0c },   // 9
+    { 0x0e, 0x11, 0x11, 0x1f, 0x11, 0x11, 0x11 },   // A
+    { 0x1e, 0x11, 0x11, 0x1e, 0x11, 0x11, 0x1e },   // B
+    { 0x0e, 0x11, 0x10, 0x10, 0x10, 0x11, 0x0e },   // C
+    { 0x1c, 0x12, 0x11, 0x11, 0x11, 0x12, 0x1c },   // D
+    { 0x1f, 0x10, 0x10, 0x1e, 0x10, 0x10, 0x1f },   // E
+    { 0x1f, 0x10, 0x10, 0x1e, 0x10, 0x10, 0x10 },   // F
+    { 0x0e, 0x11, 0x10, 0x17, 0x11, 0x11, 0x0f },   // G
+    { 0x11, 0x11, 0x11, 0x1f, 0x11, 0x11, 0x11 },   // H
+    { 0x0e, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0e },   // I
+    { 0x07, 0x02, 0x02, 0x02, 0x02, 0x12, 0x0c },   // J
+    { 0x11, 0x12, 0x14, 0x18, 0x14, 0x12, 0x11 },   // K
+    { 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x1f },   // L
+    { 0x11, 0x1b, 0x15, 0x15, 0x11, 0x11, 0x11 },   // M
+    { 0x11, 0x11, 0x19, 0x15, 0x13, 0x11, 0x11 },   // N
+    { 0x0e, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0e },   // O
+    { 0x1e, 0x11, 0x11, 0x1e, 0x10, 0x10, 0x10 },   // P
+    { 0x0e, 0x11, 0x11, 0x11, 0x15, 0x12, 0x0d },   // Q
+    { 0x1e, 0x11, 0x11, 0x1e, 0x14, 0x12, 0x11 },   // R
+    { 0x0f, 0x10, 0x10, 0x0e, 0x01, 0x01, 0x1e },   // S
+    { 0x1f, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04 },   // T
+    { 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0e },   // U
+    { 0x11, 0x11, 0x11, 0x11, 0x11, 0x0a, 0x04 },   // V
+    { 0x11, 0x11, 0x11, 0x15, 0x15, 0x15, 0x0a },   // W
+    { 0x11, 0x11, 0x0a, 0x04, 0x0a, 0x11, 0x11 },   // X
+    { 0x11, 0x11, 0x11, 0x0a, 0x04, 0x04, 0x04 },   // Y
+    { 0x1f, 0x01, 0x02, 0x04, 0x08, 0x10, 0x1f },   // Z
+    { 0x00, 0x0c, 0x0c, 0x00, 0x0c, 0x0c, 0x00 },   // :
+    { 0x00, 0x00, 0x00, 0x1f, 0x00, 0x00, 0x00 }    // -
+  };
+
+  // A line of text laid out as copies from the glyph sheet
+  struct Line {
+    int value = -1;   // Number the line shows, -1 until it is first laid out
+    std::vector<Render::Command> glyphs;  // One copy per visible character, ready to append to a frame
+  };
+
+  TextureHandle sheet;  // Every glyph side by side in one row
+  Line scoreLine;
+  Line livesLine;
+
+  // Totals for reporting
+  long long layouts = 0;
+  long long framesDrawn = 0;
+
+  // Lay out a label and a number, from the left edge or back from the right
+  // Positions are worked out on the window, then stretched to the playfield
+  // Spaces and characters the font doesn't have just advance
+  void layout(Line& line, const char* label, int value, bool alignRight) {
+    const std::string text = label + std::to_string(value);
+    const int width = static_cast<int>(text.size()) * ADVANCE * SCALE - SCALE;
+    int x = alignRight ? settings::SCREEN_WIDTH - MARGIN - width : MARGIN;
+    line.glyphs.clear();
+    for(char character : text) {
+      const char* found = std::strchr(CHARACTERS, std::toupper(static_cast<unsigned char>(character)));
+      if(character != ' ' && found != NULL) {
+        const SDL_Rect source = { static_cast<int>(found - CHARACTERS) * ADVANCE, 0, GLYPH_WIDTH, GLYPH_HEIGHT };
+        const SDL_Rect placement = Render::stretch({ x, MARGIN, GLYPH_WIDTH * SCALE, GLYPH_HEIGHT * SCALE });  // Same size on screen however big the playfield
+        line.glyphs.push_back({ sheet.get(), source, placement, Layer::hud });
+      }
+      x += ADVANCE * SCALE;
+    }
+    line.value = value;
+    layouts++;
+  }
+}
+
+namespace Hud {
+  bool init() {
+    SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormat(0, CHARACTER_COUNT * ADVANCE, GLYPH_HEIGHT, 32, SDL_PIXELFORMAT_ARGB8888);
+    if(surface == NULL) {
+      std::cout << "Unable to create the HUD font\n";
+      return false;
+    }
+    SDL_FillRect(surface, NULL, 0);
+    for(int glyph = 0; glyph < CHARACTER_COUNT; ++glyph) {
+      for(int row = 0; row < GLYPH_HEIGHT; ++row) {
+        Uint32* pixels = reinterpret_cast<Uint32*>(static_cast<Uint8*>(surface->pixels) + row * surface->pitch) + glyph * ADVANCE;
+        for(int column = 0; column < GLYPH_WIDTH; ++column) {
+          if(GLYPHS[glyph][row] & (0x10 >> column))
+            pixels[column] = COLOR;
+        }
+      }
+    }
+    SDL_Texture* texture = SDL_CreateTextureFromSurface(SDL::renderer, surface);
+    SDL_FreeSurface(surface);
+    if(texture == NULL) {
+      std::cout << "Unable to create the HUD font\n";
+      return false;
+    }
+    SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+    sheet = Resources::adopt("hud:font", texture);
+    scoreLine.value = livesLine.value = -1;   // Lay out again against the new sheet
+    return true;
+  }
+
+  void draw(Render::Frame& frame) {
+    PROFILE_SCOPE("Hud::draw");
+    if(!sheet)
+      return;
+    if(frame.score != scoreLine.value)
+      layout(scoreLine, "SCORE ", frame.score, false);
+    if(frame.lives != livesLine.value)
+      layout(livesLine, "LIVES ", frame.lives, true);
+    frame.commands.insert(frame.commands.end(), scoreLine.glyphs.begin(), scoreLine.glyphs.end());
+    frame.commands.insert(frame.commands.end(), livesLine.glyphs.begin(), livesLine.glyphs.end());
+    framesDrawn++;
+  }
+
+  void destroy() {
+    sheet.reset();
+    scoreLine.glyphs.clear();
+    livesLine.glyphs.clear();
+  }
+
+  void report(std::ostream& out) {
+    out << "HUD: " << framesDrawn << " frames drawn, text laid out " << layouts << " times\n";
+  }
+}
@@ -0,0 +1,247 @@
+#include "../include/jobs.h"
+#include "../include/profiler.h"
+#include <SDL2/SDL.h>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <algorithm>
+#include <condition_variable>
+#include <memory>
+#include <vector>
+#include <iostream>
+
+namespace {
+  const int MAX_THREADS = 64;
+  const double SPIN_SECONDS = 0.0002;   // How long an idle worker keeps looking for work before it sleeps
+
+  // One thread's jobs, a growable ring behind a lock
+  // The owner works at the back, thieves take from the front
+  struct alignas(64) Queue {
+    std::mutex mutex;
+    std::vector<Jobs::Job> jobs = std::vector<Jobs::Job>(256);  // Power of two so the index is a mask
+    std::size_t head = 0;   // Front of the ring
+    std::size_t tail = 0;   // One past the back
+    std::atomic<long long> run{ 0 };  // Jobs this thread ran
+    std::atomic<long long> stolen{ 0 };   // Of those, how many came from another thread's queue
+
+    void push(const Jobs::Job& job) {
+      std::lock_guard<std::mutex> lock(mutex);
+      if(tail - head == jobs.size()) {  // Full, double the ring keeping the order
+        std::vector<Jobs::Job> bigger(jobs.size() * 2);
+        for(std::size_t i = head; i < tail; ++i)
+          bigger[i & (bigger.size() - 1)] = jobs[i & (jobs.size() - 1)];
+        jobs.swap(bigger);
+      }
+      jobs[tail & (jobs.size() - 1)] = job;
+      tail++;
+    }
+
+    bool popBack(Jobs::Job& job) {
+      std::lock_guard<std::mutex> lock(mutex);
+      if(head == tail)
+        return false;
+      tail--;
+      job = jobs[tail & (jobs.size() - 1)];
+      return true;
+    }
+
+    bool popFront(Jobs::Job& job) {
+      std::lock_guard<std::mutex> lock(mutex);
+      if(head == tail)
+        return false;
+      job = jobs[head & (jobs.size() - 1)];
+      head++;
+      return true;
+    }
+  };
+
+  std::vector<std::unique_ptr<Queue>> queues;   // One per thread, indexed by thread index
+  std::vector<std::thread> workers;
+  std::atomic<int> queued{ 0 };   // Jobs sitting in any queue
+  std::atomic<int> sleepers{ 0 };   // Workers waiting on wake
+  std::atomic<bool> stopping{ false };
+  std::mutex sleepMutex;
+  std::condition_variable wake;
+  thread_local int localIndex = 0;   // Workers set their own, every other thread is 0 and shares the first queue
+
+  // Own queue first, newest job first, then steal the oldest job from the next thread along
+  bool findJob(Jobs::Job& job) {
+    const int count = static_cast<int>(queues.size());
+    if(queues[localIndex]->popBack(job)) {
+      queued--;
+      return true;
+    }
+    for(int i = 1; i < count; ++i) {
+      if(queues[(localIndex + i) % count]->popFront(job)) {
+        queued--;
+        queues[localIndex]->stolen.fetch_add(1, std::memory_order_relaxed);
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void execute(const Jobs::Job& job) {
+    job.run(job.context, job.index);
+    if(!queues.empty())
+      queues[localIndex]->run.fetch_add(1, std::memory_order_relaxed);
+    job.pending->fetch_sub(1, std::memory_order_release);  // Publish the job's writes to whoever waits on it
+  }
+
+  // Spin on the queues for a moment so back to back batches don't pay for a wake up, then sleep until work is queued
+  void workerLoop(int index) {
+    localIndex = index;
+    const Uint64 spinTicks = static_cast<Uint64>(SPIN_SECONDS * SDL_GetPerformanceFrequency());
+    Uint64 idleSince = SDL_GetPerformanceCounter();
+    while(!stopping.load(std::memory_order_relaxed)) {
+      Jobs::Job job;
+      if(findJob(job)) {
+        execute(job);
+        idleSince = SDL_GetPerformanceCounter();
+        continue;
+      }
+      if(SDL_GetPerformanceCounter() - idleSince < spinTicks) {
+        std::this_thread::yield();
+        continue;
+      }
+      std::unique_lock<std::mutex> lock(sleepMutex);
+      sleepers++;
+      wake.wait(lock, [] { return stopping.load() || queued.load() > 0; });
+      sleepers--;
+      idleSince = SDL_GetPerformanceCounter();
+    }
+  }
+}
+
+namespace Jobs {
+  void init(int threads) {
+    shutdown();
+    if(threads <= 0)
+      threads = SDL_GetCPUCount();
+    threads = std::clamp(threads, 1, MAX_THREADS);
+    for(int i = 0; i < threads; ++i)
+      queues.push_back(std::make_unique<Queue>());
+    stopping = false;
+    localIndex = 0;
+    for(int i = 1; i < threads; ++i)
+      workers.emplace_back(workerLoop, i);
+  }
+
+  void shutdown() {
+    {
+      std::lock_guard<std::mutex> lock(sleepMutex);
+      stopping = true;
+    }
+    wake.notify_all();
+    for(std::thread& worker : workers)
+      worker.join();
+    workers.clear();
+    queues.clear();
+    queued = 0;
+  }
+
+  int threadCount() {
+    return queues.empty() ? 1 : static_cast<int>(queues.size());
+  }
+
+  int threadIndex() {
+    return localIndex;
+  }
+
+  // Without init there are no queues, so the job just runs here
+  void submit(const Job& job) {
+    if(queues.empty()) {
+      execute(job);
+      return;
+    }
+    queues[localIndex]->push(job);
+    queued++;
+    if(sleepers.load() > 0) {   // Either we see the sleeper, or it sees the job before it sleeps
+      std::lock_guard<std::mutex> lock(sleepMutex);
+      wake.notify_one();
+    }
+  }
+
+  void wait(const std::atomic<int>& pending) {
+    PROFILE_SCOPE("Jobs::wait");
+    while(pending.load(std::memory_order_acquire) > 0) {
+      Job job;
+      if(!queues.empty() && findJob(job))
+        execute(job);
+      else
+        std::this_thread::yield();
+    }
+  }
+
+  bool tryRun() {
+    Job job;
+    if(queues.empty() || !findJob(job))
+      return false;
+    execute(job);
+    return true;
+  }
+
+  void report(std::ostream& out) {
+    long long run = 0;
+    long long stolen = 0;
+    for(const auto& queue : queues) {
+      run += queue->run.load(std::memory_order_relaxed);
+      stolen += queue->stolen.load(std::memory_order_relaxed);
+    }
+    out << "Jobs: " << threadCount() << " threads ran " << run << " jobs, " << stolen << " stolen\n";
+  }
+}
+
+int TaskGraph::add(std::function<void()> work) {
+  tasks.push_back(std::make_unique<Task>());
+  tasks.back()->work = std::move(work);
+  return static_cast<int>(tasks.size()) - 1;
+}
+
+void TaskGraph::precede(int before, int after) {
+  tasks[before]->dependents.push_back(after);
+  tasks[after]->dependencies++;
+}
+
+// Run a task, then queue every dependent it was the last dependency of
+void TaskGraph::runTask(void* context, int index) {
+  TaskGraph* graph = static_cast<TaskGraph*>(context);
+  Task& task = *graph->tasks[index];
+  task.work();
+  for(int dependent : task.dependents) {
+    if(graph->tasks[dependent]->waiting.fetch_sub(1, std::memory_order_acq_rel) == 1)
+      Jobs::submit({ runTask, graph, dependent, &graph->pending });
+  }
+}
+
+void TaskGraph::run() {
+  PROFILE_SCOPE("TaskGraph::run");
+  for(auto& task : tasks)
+    task->waiting = task->dependencies;
+
+  // With no other threads the queues are pure overhead, run each task here as soon as it is ready
+  if(Jobs::threadCount() <= 1) {
+    ready.clear();
+    for(int i = size() - 1; i >= 0; --i) {
+      if(tasks[i]->dependencies == 0)
+        ready.push_back(i);
+    }
+    while(!ready.empty()) {
+      Task& task = *tasks[ready.back()];
+      ready.pop_back();
+      task.work();
+      for(int dependent : task.dependents) {
+        if(--tasks[dependent]->waiting == 0)
+          ready.push_back(dependent);
+      }
+    }
+    return;
+  }
+
+  pending = size();
+  for(int i = size() - 1; i >= 0; --i) {  // Backwards so this thread picks up the first task first
+    if(tasks[i]->dependencies == 0)
+      Jobs::submit({ runTask, this, i, &pending });
+  }
+  Jobs::wait(pending);
+}
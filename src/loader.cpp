@@ -0,0 +1,139 @@
+#include "../include/loader.h"
+#include "../include/jobs.h"
+#include "../include/profiler.h"
+#include <SDL2/SDL.h>
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <iostream>
+
+namespace {
+  // One image on its way to becoming a texture
+  struct Request {
+    std::string name;
+    Loader::Decode decode;
+    Loader::Upload upload;
+    SDL_Surface* surface = NULL;  // Decoded image, NULL if decoding failed
+  };
+
+  std::vector<std::unique_ptr<Request>> requests;   // Every request, in order
+  std::size_t nextDecode = 0;   // First request no job has started on
+  std::deque<Request*> decoded;   // Decoded and waiting for upload
+  std::mutex mutex;   // Guards nextDecode and decoded
+  std::atomic<int> decoding{ 0 };   // Decode jobs queued or running
+
+  int uploaded = 0;   // Requests finished, uploaded or failed
+  int failed = 0;
+  Uint64 started = 0;   // Counter at the first request
+  Uint64 shown = 0;     // Counter at the first frame
+  Uint64 finished = 0;  // Counter once everything was uploaded
+
+  double msSince(Uint64 start, Uint64 end) {
+    return static_cast<double>(end - start) * 1000.0 / SDL_GetPerformanceFrequency();
+  }
+
+  // Every decode job takes the oldest request nobody has started on, so decodes start in the order they were asked for
+  // no matter which thread runs which job
+  void decodeNext(void*, int) {
+    PROFILE_SCOPE("Loader::decode");
+    Request* request = NULL;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      request = requests[nextDecode++].get();
+    }
+    request->surface = request->decode();
+    std::lock_guard<std::mutex> lock(mutex);
+    decoded.push_back(request);
+  }
+
+  Request* takeDecoded() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if(decoded.empty())
+      return NULL;
+    Request* request = decoded.front();
+    decoded.pop_front();
+    return request;
+  }
+}
+
+namespace Loader {
+  void request(const std::string& name, Decode decode, Upload upload) {
+    if(requests.empty() || done())  // Time a new batch from here
+      started = SDL_GetPerformanceCounter();
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      requests.push_back(std::make_unique<Request>());
+      Request& added = *requests.back();
+      added.name = name;
+      added.decode = std::move(decode);
+      added.upload = std::move(upload);
+    }
+    decoding++;
+    Jobs::submit({ decodeNext, NULL, 0, &decoding });
+  }
+
+  // Uploads always make progress, at least one goes through however long it takes
+  bool update(double budgetMs) {
+    PROFILE_SCOPE("Loader::update");
+    const Uint64 start = SDL_GetPerformanceCounter();
+    const int failedBefore = failed;
+    while(!done()) {
+      Request* request = takeDecoded();
+      if(request == NULL) {
+        // Nothing to upload yet, decode here while there is time, all of it if there are no worker threads
+        if(msSince(start, SDL_GetPerformanceCounter()) < budgetMs && Jobs::tryRun())
+          continue;
+        break;
+      }
+      {
+        PROFILE_SCOPE("Loader::upload");
+        if(request->surface == NULL || !request->upload(request->surface)) {
+          std::cout << "Failed to load " << request->name << '\n';
+          failed++;
+        }
+      }
+      SDL_FreeSurface(request->surface);
+      request->surface = NULL;
+      uploaded++;
+      if(msSince(start, SDL_GetPerformanceCounter()) >= budgetMs)
+        break;
+    }
+    if(done() && finished == 0)
+      finished = SDL_GetPerformanceCounter();
+    return failed == failedBefore;
+  }
+
+  bool done() {
+    return uploaded == static_cast<int>(requests.size());
+  }
+
+  float progress() {
+    return requests.empty() ? 1.0f : static_cast<float>(uploaded) / requests.size();
+  }
+
+  void abandon() {
+    Jobs::wait(decoding);
+    while(Request* request = takeDecoded())
+      SDL_FreeSurface(request->surface);
+    requests.clear();
+    nextDecode = 0;
+    uploaded = 0;
+  }
+
+  void firstFrame() {
+    if(shown == 0)
+      shown = SDL_GetPerformanceCounter();
+  }
+
+  void report(std::ostream& out) {
+    if(requests.empty())
+      return;
+    out << "Loading: " << uploaded - failed << " of " << requests.size() << " images in " << msSince(started, finished) << "ms";
+    if(shown != 0)
+      out << ", first frame after " << msSince(started, shown) << "ms";
+    out << '\n';
+  }
+}
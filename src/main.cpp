@@ -2,15 +2,38 @@
 #include <cstdlib>
 #include <ctime>
 #include <cassert>
+#include <algorithm>
 #include <iostream>
 #include <ostream>
 #include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
 #include <SDL2/SDL.h>
 #include "../include/engine.h"
 #include "../include/types.h"
 #include "../include/sprite.h"
+#include "../include/ecs.h"
+#include "../include/systems.h"
+#include "../include/swarm.h"
+#include "../include/projectiles.h"
+#include "../include/effects.h"
 #include "../include/background.h"
+#include "../include/atlas.h"
+#include "../include/mapformat.h"
 #include "../include/settings.h"
+#include "../include/timestep.h"
+#include "../include/spatialhash.h"
+#include "../include/collide.h"
+#include "../include/profiler.h"
+#include "../include/replay.h"
+#include "../include/jobs.h"
+#include "../include/render.h"
+#include "../include/batch.h"
+#include "../include/loader.h"
+#include "../include/archive.h"
+#include "../include/hud.h"
+#include "../include/pacer.h"
 
 
 /****************************** GLOBAL DATA ***********************************/
@@ -23,50 +46,104 @@ const int MAX_ROUNDS = 3;   // Maximum number of rounds of play
 bool newRound = false;   // Do we need to set up the next round?
 bool playGame = false;  // Menu state variable
 bool startRound = false; // Start the next round
-bool menuDeleted = false;   // Did we delete the menu object?
 bool playerWin = false;     // Did the player win?
+int menuCooldown = 0;   // Ticks to ignore START for after it was pressed
+const int PLAYER_SPEED = 5;   // Pixels the player moves each tick
 
 // Declare Global game objects
 // To be intialized in init functions
 Background* background = NULL;
 Tilemap* tilemap = NULL;
-AnimatedSprite* logo = NULL;        // Pointers to all sprite objects
-AnimatedSprite* roundOne = NULL;
-AnimatedSprite* roundTwo = NULL;
-AnimatedSprite* roundThree = NULL;
-AnimatedSprite* winLogo = NULL;
-AnimatedSprite* loseLogo = NULL;
-AnimatedSprite* start = NULL;
-AnimatedSprite* player = NULL;
-AnimatedSprite* explosion = NULL;
-AlienRow* topRow = NULL;    // Alien Rows hold 10 alien sprites
-AlienRow* upperRow = NULL;
-AlienRow* lowerRow = NULL;
-AlienRow* bottomRow = NULL;
-Bullets* bullets = NULL;    // Bullets holds 5 bullets to rotate through
+World* world = NULL;    // The player, menu sprites and explosions, as entities
+Entity logo;        // Logo currently being displayed
+Entity titleLogo;   // Handles to every sprite entity
+Entity roundOne;
+Entity roundTwo;
+Entity roundThree;
+Entity winLogo;
+Entity loseLogo;
+Entity start;
+Entity player;
+AlienSwarm* swarm = NULL;   // Swarm holds every alien in the wave
+ProjectilePool* projectiles = NULL;   // Every shot in flight
+TaskGraph updateGraph;  // The passes of game::update, built once by createObjects
+
+// Shared between the simulation thread and the render thread
+FrameQueue frameQueue;  // Finished frames on their way to the screen
+FramePacer framePacer;  // Holds presented frames to the frame cap
+std::atomic<Uint8> buttonsHeld{ 0 };  // Latest input, read by the render thread for the simulation
+std::atomic<bool> quitRequested{ false };   // The window was closed or ESC was pressed
+std::atomic<bool> simulationDone{ false };  // The game is over
+const int FRAME_WAIT_MS = 5;   // Longest the render thread waits for a frame before checking for input again
+const double LOAD_BUDGET_MS = 4.0;  // Time each loading screen frame spends turning images into textures
 
 // Function Prototypes
 // Game state functions
 void createObjects();   // Instantiate game objects and set initial states
 void createAliens(int speed);   // Create all alien objects
+Entity createSprite(ComponentMask components, const std::string& path, Layer layer);  // Create an entity showing a sprite sheet
 void destroyObjects();  // Free memory associated with instantiated objects and nullify pointers
 void deleteAliens();    // Delete all alien objects
 
 // Gameplay Functions
 namespace game {
   bool init();  // Initialize all game objects
+  bool load();  // Show a loading screen until every image queued has loaded
   void end();   // Destory game objects and end game
+  bool tick(Uint8 buttons);  // Advance the simulation by one fixed tick
+  bool step(Uint8 buttons);  // Run one tick, recording it or taking its input from the replay being played
+  std::uint32_t stateHash();  // Hash of everything that decides how the game plays out
+  void simulate();  // Run the simulation, building frames for the render thread
+  void render(Render::Frame& frame, float alpha);   // Build the current screen into a frame, interpolated between ticks
+  void present(Render::Frame& frame);   // Put a frame on screen, render thread only
   void update();    // Update the state of each object
-  void draw();  // Draw each object to the render
+  void draw(Render::Frame& frame, float alpha);  // Add each object to the frame
   void nextRound(); // Set up environment for next round of play
   void setMenu(int round);      // Set which menu to display between each round
-  void displayMenu(const Uint8* pressedKeys);   // Display a start menu
+  void showLogo(Entity next);   // Hide the current logo and show another, NO_ENTITY for none
+  void movePlayer(Direction direction);   // Move the player one step, stopping at the edges
+  void centerPlayer();  // Put the player back at the bottom middle of the playfield
+  void updateMenu(Uint8 buttons);   // Run a tick of the start menu
+  void drawMenu(Render::Frame& frame, float alpha);   // Add the start menu to the frame
   void displayEnd();    // Display win or lose message at the end
-  void drawExplosion();
+  void reset();     // Return all game state to the start of a new game
+  void runHeadless();   // Simulate games as fast as possible with no window
 }
 
 // Begin main function
 int main(int argc, char* argv[]) {
+  // Read runtime options from the command line
+  if(!settings::parseArgs(argc, argv)) {
+    std::cout << "Usage: SDL-Invaders [--tick-rate N] [--max-fps N] [--vsync] [--headless] [--games N] [--texture-budget MB]\n"
+              << "                    [--projectiles N] [--trace FILE] [--trace-frames FIRST-LAST]\n"
+              << "                    [--seed N] [--record FILE] [--replay FILE] [--replay-fast] [--threads N]\n"
+              << "                    [--dirty-rects] [--swarm ROWSxCOLUMNS] [--gap N] [--gutter N] [--swarm-speed N]\n"
+              << "                    [--volley N] [--fire-delay N] [--preset NAME] [--config FILE]\n";
+    return 1;
+  }
+  Profiler::configure(settings::traceFile, settings::traceFirstFrame, settings::traceLastFrame);
+
+  // A replay brings its own seed and tick rate
+  if(!settings::replayFile.empty() && !Replay::load(settings::replayFile, settings::seed, settings::tickRate))
+    return 1;
+
+  // Simulate without a window and report throughput
+  if(settings::headless) {
+    if(!game::init()) {
+      std::cout << "Critical error, terminating program\n";
+      return 1;
+    }
+    game::runHeadless();
+    Profiler::finish();
+    Replay::stopRecording();
+    Replay::report(std::cout);
+    Jobs::report(std::cout);
+    Jobs::shutdown();
+    destroyObjects();
+    SDL::CloseShop();
+    return 0;
+  }
+
   // Print out directions
   std::cout << "Directions:\n";
   std::cout << "  Your spaceship is under attack! Fend off the invading waves of alien\n"
@@ -88,177 +165,400 @@ int main(int argc, char* argv[]) {
     return 1;
   }
 
+  // With vsync the display sets the pace, measure frames against its refresh rate
+  int targetFps = settings::maxFps;
+  SDL_DisplayMode mode;
+  if(settings::vsync && SDL_GetWindowDisplayMode(SDL::gameWindow, &mode) == 0 && mode.refresh_rate > 0)
+    targetFps = mode.refresh_rate;
+  framePacer.setTarget(targetFps, settings::vsync);
+
   // BEGIN GAME LOOP
-  while(SDL::ProgramIsRunning()) {
+  // The simulation runs in fixed ticks on its own thread and hands each frame over as a render command list
+  // This thread owns the window and the renderer, it reads input and draws the newest frame as often as the frame cap allows
+  std::thread simulation(game::simulate);
+  while(!simulationDone && SDL::ProgramIsRunning()) {
+    Profiler::frame();
+    PROFILE_SCOPE("frame");
+
     // Get key press from keyboard and interpret
     const Uint8 *keys = SDL_GetKeyboardState(NULL);
 
     // End game at any time with 'ESC'
     if(keys[SDL_SCANCODE_ESCAPE])
       break;
+    buttonsHeld.store(Replay::readKeyboard(keys));
 
-    // Check for left and right arrow keypresses
-    // Move the player sprite accordingly
-    // This is outside the game loop so the player can have fun before pressing start
-    if(keys[SDL_SCANCODE_LEFT]) {
-      player->setDirection(Direction::left);
-      player->move();
-    }
-    if(keys[SDL_SCANCODE_RIGHT]) {
-      player->setDirection(Direction::right);
-      player->move();
+    // Draw the newest frame, if the simulation has finished one since the last, and hold it until the next is due
+    if(Render::Frame* frame = frameQueue.acquire(FRAME_WAIT_MS)) {
+      game::present(*frame);
+      framePacer.wait();
     }
+  }
+  // Stop the simulation, then display end menu and exit
+  quitRequested = true;
+  frameQueue.close();
+  simulation.join();
+  Profiler::finish();
+  Replay::stopRecording();
+  Replay::report(std::cout);
+  game::end();
+  return 0;
+}
 
-    // Display a menu until the player quits or selects 'START' (Space Key)
-    if(!playGame) {
-      game::displayMenu(keys);
+// Simulation thread
+// Runs every tick that has come due, then builds a frame blending sprites between the last two ticks
+// Once the frame is handed over it waits for the render thread to take it, but never past the next tick
+void game::simulate() {
+  FixedTimestep timestep(settings::tickRate);
+  bool running = true;
+  while(running && !quitRequested) {
+    PROFILE_SCOPE("game::simulate");
+    Uint8 buttons = buttonsHeld.load();
+    float alpha = 1.0f;
+
+    // Fast replays run as many ticks as fit in a 60Hz frame, then show where they got to
+    if(settings::replayFast && Replay::isPlaying()) {
+      Uint64 start = SDL_GetPerformanceCounter();
+      Uint64 budget = SDL_GetPerformanceFrequency() / 60;
+      while(running && SDL_GetPerformanceCounter() - start < budget)
+        running = game::step(buttons);
     }
-    
-    // Play the game 
     else {
-      // Check for new round
-      if(newRound)
-        game::nextRound();
-
-      if(!startRound) {
-        // Point the logo pointer to the current round
-        game::setMenu(currentRound);
-        // And display the menu
-        game::displayMenu(keys);
-      }
-      else {
-        
-        // Check for Space key press
-        // If pressed, fire a bullet from the player sprite
-        bulletTimer++;        // Increment the bullet timer to see if we can fire this tick
-        if(keys[SDL_SCANCODE_SPACE]) {
-          bullets->fire(*player);
-        }
-        
-        // Update state of all game objects before drawing
-        game::update();
-        
-        // Draw all active objects to the render
-        game::draw();
-
-        // CHECK COLLISIONS!!
-        bullets->checkCollisions(*bottomRow);
-        bullets->checkCollisions(*lowerRow);
-        bullets->checkCollisions(*upperRow);
-        bullets->checkCollisions(*topRow);
-        //bottomRow->checkExplode();
-        //lowerRow->checkExplode();
-        //upperRow->checkExplode();
-        //topRow->checkExplode();
-        if(bottomRow->checkCollisions(*player) || lowerRow->checkCollisions(*player) || upperRow->checkCollisions(*player) || topRow->checkCollisions(*player)) {
-          topRow->resetLocation();
-          upperRow->resetLocation();
-          lowerRow->resetLocation();
-          bottomRow->resetLocation();
-        }
-        
-        // CHECK FOR WIN/LOSS
-        // Check if player loses
-        if(playerLives <= 0) {
-          std::cout << "Player loses\n";
-          playerWin = false;
+      timestep.advance();
+      while(timestep.step()) {
+        if(!game::step(buttons)) {   // Game over, stop the loop
+          running = false;
           break;
         }
-        // Check if all enemies are destoryed
-        if(topRow->isEmpty() && upperRow->isEmpty() && lowerRow->isEmpty() && bottomRow->isEmpty()) {
-          // Check if player won
-          if(currentRound == MAX_ROUNDS) {
-            std::cout << "Player wins!\n";
-            playerWin = true;
-            break;
-          }
-          newRound = true;
-        }
       }
+      alpha = timestep.alpha();
     }
+    if(!running)
+      break;
+
+    game::render(frameQueue.back(), alpha);
+    frameQueue.publish();
+    if(!settings::replayFast || !Replay::isPlaying())
+      frameQueue.waitTaken(timestep.msToStep());
   }
-  // Display end menu and exit
-  game::end();
-  return 0;
+  simulationDone = true;
+  frameQueue.close();   // Wake the render thread if it is waiting on a frame
+}
+
+// Run one tick of the game
+// While recording, the buttons and resulting state hash are saved
+// While playing a replay, the recorded buttons are used instead and the state hash is checked
+// Returns false when the game is over or the replay has run out
+bool game::step(Uint8 buttons) {
+  if(Replay::isPlaying() && !Replay::next(buttons))
+    return false;
+  bool running = game::tick(buttons);
+  if(Replay::isRecording() || Replay::isPlaying()) {
+    std::uint32_t hash = game::stateHash();
+    Replay::record(buttons, hash);
+    Replay::verify(hash);
+  }
+  return running;
+}
+
+// Hash the game state, replays compare it every tick to prove they play out the same
+std::uint32_t game::stateHash() {
+  const int state[] = {
+    playerScore, playerLives, currentRound, newRound, playGame, startRound, playerWin, menuCooldown, bulletTimer,
+    world->get<Transform>(player)->position.x, world->get<Transform>(player)->position.y
+  };
+  std::uint32_t hash = hashBytes(state, sizeof(state));
+  hash = swarm->checksum(hash);
+  return projectiles->checksum(hash);
+}
+
+// Advance the simulation by one fixed tick
+// Returns false when the game is over
+bool game::tick(Uint8 buttons) {
+  PROFILE_SCOPE("game::tick");
+  Systems::snapshot(*world);  // Entities interpolate from where this tick starts
+
+  // Check for left and right arrow keypresses
+  // Move the player sprite accordingly
+  // This is outside the game loop so the player can have fun before pressing start
+  if(buttons & Replay::LEFT)
+    game::movePlayer(Direction::left);
+  if(buttons & Replay::RIGHT)
+    game::movePlayer(Direction::right);
+
+  // Display a menu until the player quits or selects 'START' (Space Key)
+  if(!playGame) {
+    game::updateMenu(buttons);
+    return true;
+  }
+
+  // Play the game 
+  // Check for new round
+  if(newRound)
+    game::nextRound();
+
+  if(!startRound) {
+    // Show the logo for the current round
+    game::setMenu(currentRound);
+    // And display the menu
+    game::updateMenu(buttons);
+    return true;
+  }
+
+  // Check for Space key press
+  // If pressed, fire a bullet from the player sprite
+  bulletTimer++;        // Increment the bullet timer to see if we can fire this tick
+  if(buttons & Replay::FIRE) {
+    projectiles->fire(Systems::bounds(*world, player));
+  }
+  
+  // Update state of all game objects
+  game::update();
+
+  // CHECK COLLISIONS!!
+  projectiles->checkCollisions(*swarm);
+  if(swarm->checkCollisions(Systems::bounds(*world, player))) {
+    swarm->resetLocation();
+  }
+  
+  // CHECK FOR WIN/LOSS
+  // Check if player loses
+  if(playerLives <= 0) {
+    playerWin = false;
+    return false;
+  }
+  // Check if all enemies are destoryed
+  if(swarm->isEmpty()) {
+    // Check if player won
+    if(currentRound == MAX_ROUNDS) {
+      playerWin = true;
+      return false;
+    }
+    newRound = true;
+  }
+  return true;
+}
+
+// Build whichever screen the current state calls for
+void game::render(Render::Frame& frame, float alpha) {
+  PROFILE_SCOPE("game::render");
+  frame.clear();
+  frame.score = playerScore;
+  frame.lives = playerLives;
+  if(playGame && startRound)
+    game::draw(frame, alpha);
+  else
+    game::drawMenu(frame, alpha);
+}
+
+// Put a finished frame on screen
+void game::present(Render::Frame& frame) {
+  PROFILE_SCOPE("game::present");
+  if(tilemap != NULL)
+    tilemap->prepare();
+  Hud::draw(frame);
+  Render::draw(frame);
+  Loader::firstFrame();
 }
 
 // Initialize all objects
 bool game::init() {
+  PROFILE_SCOPE("game::init");
   //Initialize SDL
   if(!SDL::Init())
     return false;
+  Jobs::init(settings::threads);
+
+  // Every image, the map and the sprite animations come out of the one cooked archive
+  if(!Archive::open("graphics/assets.pak")) {
+    std::cout << "Build the assets target to cook it\n";
+    return false;
+  }
+
+  // Queue every image to load in the background, the backdrop first so the loading screen has something to show
+  // Sprite sheets are packed into the texture atlas, if it fails sprites fall back to loading their own textures
+  if(!settings::headless) {
+    Resources::preload("graphics/bg.bmp");
+    const std::vector<Atlas::Sheet> spriteSheets = {
+      { "graphics/logo.bmp", "#000000" },
+      { "graphics/roundone.bmp", "#000000" },
+      { "graphics/roundtwo.bmp", "#000000" },
+      { "graphics/roundthree.bmp", "#000000" },
+      { "graphics/win.bmp", "#000000" },
+      { "graphics/lose.bmp", "#000000" },
+      { "graphics/start.bmp", "#000000" },
+      { "graphics/sprite.bmp", "#000000" },
+      { "graphics/explosion.bmp", "#000000" },
+      { alienSheetPath, alienTransparency },
+      { bulletSheetPath, bulletTransparency }
+    };
+    Atlas::build(spriteSheets, "graphics/atlas.cache");
+    for(const mapformat::Sheet& sheet : mapformat::SHEETS)
+      Resources::preload(sheet.path, hexToRGB(sheet.transparency));
+    Hud::init();  // Score and lives on screen, the game still plays without them
+    if(!game::load())
+      return false;
+  }
 
   //Initialize static textures
-  if(!Alien::init() || !Bullet::init()) {
+  if(!AlienSwarm::init() || !ProjectilePool::init() || !Effects::init()) {
     return false;
   }
   SDL::static_init = true;  // Set static initialization flag to true
 
+  // Size the playfield to the swarm before anything is placed on it
+  AlienSwarm::fitField();
+  if(!settings::headless)
+    Render::fitField();
+  std::cout << "Swarm: " << settings::swarmRows << 'x' << settings::swarmColumns << " aliens on a "
+            << settings::fieldWidth << 'x' << settings::fieldHeight << " playfield\n";
+
   //Create game objects
   createObjects();
+  game::reset();  // Start from exactly the state a reset gives, so replays line up with headless games
+
+  // Record from the first tick, with the seed so the game can be played again
+  if(!settings::recordFile.empty() && !Replay::startRecording(settings::recordFile, settings::seed, settings::tickRate))
+    return false;
+  std::cout << "Seed: " << settings::seed << '\n';
 
   return true;  // If we made it this far then we initialized successfully
 }
 
+// Upload images as the workers decode them, keeping the window responsive
+// The loading screen is the scrolling background and a progress bar, shown as soon as the background is ready
+bool game::load() {
+  PROFILE_SCOPE("game::load");
+  const SDL_Color trackColor = { 60, 60, 60, 255 };
+  const SDL_Color barColor = { 255, 255, 255, 255 };
+  const SDL_Rect track = { settings::SCREEN_WIDTH / 4, settings::SCREEN_HEIGHT * 3 / 4, settings::SCREEN_WIDTH / 2, 16 };
+  TextureHandle backdrop;
+  Render::Frame frame;
+  int offset = 0;
+  while(!Loader::done()) {
+    if(!SDL::ProgramIsRunning()) {   // Closed before we got going
+      Loader::abandon();
+      std::cout << "Loading cancelled\n";
+      return false;
+    }
+    Loader::update(LOAD_BUDGET_MS);   // Anything that fails is reported and left to load again when it is used
+    if(!backdrop)
+      backdrop = Resources::peek("graphics/bg.bmp");
+    if(!backdrop)
+      continue;   // Nothing to show yet
+
+    offset = (offset + 3) % settings::SCREEN_HEIGHT;  // Scroll like the menu does
+    frame.clear();
+    frame.addWhole(Layer::background, backdrop.get(), { 0, offset, settings::SCREEN_WIDTH, settings::SCREEN_HEIGHT });
+    frame.addWhole(Layer::background, backdrop.get(), { 0, offset - settings::SCREEN_HEIGHT, settings::SCREEN_WIDTH, settings::SCREEN_HEIGHT });
+    frame.fill(Layer::menu, track, trackColor);
+    frame.fill(Layer::menu, { track.x, track.y, static_cast<int>(track.w * Loader::progress()), track.h }, barColor);
+    Render::draw(frame);
+    Loader::firstFrame();
+  }
+  return true;
+}
+
 // End the game
 void game::end() {
   // If player wins set the logo to win logo
   if(playerWin) {
-    logo = winLogo;
+    std::cout << "Player wins!\n";
+    game::showLogo(winLogo);
   }
   // Otherwise set to lose logo
   else {
-    logo = loseLogo;
+    std::cout << "Player loses\n";
+    game::showLogo(loseLogo);
   }
+  world->get<Sprite>(start)->visible = false;
   // Display the end menu
   game::displayEnd();
+  SpriteBatch::report(std::cout);
+  Render::report(std::cout);
+  Loader::report(std::cout);
+  framePacer.report(std::cout);
+  Hud::report(std::cout);
+  SpatialHash::report(std::cout);
+  Collide::report(std::cout);
+  Resources::report(std::cout);
+  Jobs::report(std::cout);
+  Jobs::shutdown();
   // Destroy all objects
   destroyObjects();
+  Atlas::destroy();
+  Hud::destroy();
+  alienTextureSheet.reset();
+  Effects::destroy();
+  Sprites::release();
+  bulletTextureSheet.reset();
   // Destroy SDL objects and end session
   SDL::CloseShop();
 }
 
 // Instantiate all objects with initial values
 void createObjects() {
+  PROFILE_SCOPE("createObjects");
   background = new Background("graphics/bg.bmp");
-  tilemap = new Tilemap("graphics/tilemap.bmp");
-  logo = new AnimatedSprite("graphics/logo.bmp", 1, 0, "#000000");
-  roundOne = new AnimatedSprite("graphics/roundone.bmp", 1, 0, "#000000");
-  roundTwo = new AnimatedSprite("graphics/roundtwo.bmp", 1, 0, "#000000");
-  roundThree = new AnimatedSprite("graphics/roundthree.bmp", 1, 0, "#000000");
-  winLogo = new AnimatedSprite("graphics/win.bmp", 1, 0, "#000000");
-  loseLogo = new AnimatedSprite("graphics/lose.bmp", 1, 0, "#000000");
-  start = new AnimatedSprite("graphics/start.bmp", 2, 50, "#000000");
-  player = new AnimatedSprite("graphics/sprite.bmp", 16, 2, "#000000");
-  explosion = new AnimatedSprite("graphics/explosion.bmp", 8, 1, "#000000");
-  bullets = new Bullets();
+  if(!settings::headless)  // The tilemap is only ever drawn
+    tilemap = new Tilemap("graphics/map.tmb");
+  world = new World();
+  titleLogo = createSprite(0, "graphics/logo.bmp", Layer::menu);
+  roundOne = createSprite(0, "graphics/roundone.bmp", Layer::menu);
+  roundTwo = createSprite(0, "graphics/roundtwo.bmp", Layer::menu);
+  roundThree = createSprite(0, "graphics/roundthree.bmp", Layer::menu);
+  winLogo = createSprite(0, "graphics/win.bmp", Layer::menu);
+  loseLogo = createSprite(0, "graphics/lose.bmp", Layer::menu);
+  start = createSprite(ANIMATION, "graphics/start.bmp", Layer::menu);
+  player = createSprite(ANIMATION | COLLIDER, "graphics/sprite.bmp", Layer::actors);
+  projectiles = new ProjectilePool(settings::projectileCapacity);
   createAliens(1);
 
-  // Set object location and update render position
-  logo->setLocation({ (settings::SCREEN_WIDTH - logo->getWidth()) / 2, -30 });
-  logo->update();
-  roundOne->setLocation({ (settings::SCREEN_WIDTH - roundOne->getWidth()) / 2, -30 });
-  roundOne->update();
-  roundTwo->setLocation({ (settings::SCREEN_WIDTH - roundTwo->getWidth()) / 2, -30 });
-  roundTwo->update();
-  roundThree->setLocation({ (settings::SCREEN_WIDTH - roundThree->getWidth()) / 2, -30 });
-  roundThree->update();
-  winLogo->setLocation({ (settings::SCREEN_WIDTH - winLogo->getWidth()) / 2, -30 });
-  winLogo->update();
-  loseLogo->setLocation({ (settings::SCREEN_WIDTH - loseLogo->getWidth()) / 2, -30 });
-  loseLogo->update();
-  start->setLocation({(settings::SCREEN_WIDTH - start->getWidth()) / 2, settings::SCREEN_HEIGHT - (2 * player->getHeight() + 30)});
-  start->update();
-  player->setSpeed(5);
-  explosion->isActive = false;
+  // Center every logo along the top, only the current one is shown
+  for(Entity entity : { titleLogo, roundOne, roundTwo, roundThree, winLogo, loseLogo }) {
+    Transform* transform = world->get<Transform>(entity);
+    transform->position = { (settings::fieldWidth - world->get<Sprite>(entity)->source.w) / 2, -30 };
+    transform->previous = transform->position;
+    world->get<Sprite>(entity)->visible = false;
+  }
+  game::showLogo(titleLogo);
+
+  // Start prompt sits just above the player
+  Transform* transform = world->get<Transform>(start);
+  transform->position = { (settings::fieldWidth - world->get<Sprite>(start)->source.w) / 2,
+                          settings::fieldHeight - (2 * world->get<Sprite>(player)->source.h + 30) };
+  transform->previous = transform->position;
+  game::centerPlayer();
+
+  // Nothing in one pass touches another's objects, so none of them wait on each other
+  if(updateGraph.size() == 0) {
+    updateGraph.add([] { Systems::animate(*world); Systems::age(*world); });
+    updateGraph.add([] { background->scroll(); });
+    updateGraph.add([] { swarm->update(); });
+    updateGraph.add([] { projectiles->update(); });
+  }
+}
+
+// Create an entity with a transform and a sprite, plus the components asked for
+// Animations play the whole strip as the asset archive describes it, colliders cover a single frame
+Entity createSprite(ComponentMask components, const std::string& path, Layer layer) {
+  const Animation strip = Sprites::animation(path);
+  Entity entity = world->create(components | TRANSFORM | SPRITE);
+  Sprite* sprite = world->get<Sprite>(entity);
+  *sprite = Sprites::load(path, strip.frames, "#000000");
+  sprite->layer = layer;
+  if(Animation* animation = world->get<Animation>(entity))
+    *animation = strip;
+  if(Collider* collider = world->get<Collider>(entity)) {
+    collider->width = sprite->source.w;
+    collider->height = sprite->source.h;
+  }
+  return entity;
 }
 
 // Instantiate all alien objects with given speed
 void createAliens(int speed) {
-  topRow = new AlienRow(Rank::first, speed);
-  upperRow = new AlienRow(Rank::second, speed);
-  lowerRow = new AlienRow(Rank::third, speed);
-  bottomRow = new AlienRow(Rank::fourth, speed);
+  swarm = new AlienSwarm(settings::swarmRows, settings::swarmColumns, speed);
 }
 
 // Destory all objects and assign pointers to NULL to prevent invalid memory access
@@ -267,171 +567,142 @@ void destroyObjects() {
   // Delete each object
   delete background;
   delete tilemap;
-  delete start;
-  delete logo;
-  if(playerWin)
-    delete loseLogo;
-  else
-    delete winLogo;
-  delete player;
-  delete explosion;
-  delete bullets;
+  delete world;   // Takes every entity with it
+  delete projectiles;
 
   // Reset pointers to prevent undefined behavior
   background = NULL;
   tilemap = NULL;
-  start = NULL;
-  logo = NULL;
-  winLogo = NULL;
-  loseLogo = NULL;
-  player = NULL;
-  explosion = NULL;
-  bullets = NULL;
+  world = NULL;
+  projectiles = NULL;
 }
 
 // Delete all alien objects and assign pointers to NULL
 void deleteAliens() {
-  delete topRow;
-  delete upperRow;
-  delete lowerRow;
-  delete bottomRow;
-  topRow = NULL;
-  upperRow = NULL;
-  lowerRow = NULL;
-  bottomRow = NULL; 
+  delete swarm;
+  swarm = NULL;
 
 }
 
 // Update all object animations and update render locations
+// Each pass works on its own objects, so they run side by side as a task graph
 void game::update() {
-    // Advance to next frame
-    player->nextFrame();
-    background->scroll();
-
-    // Update each object
-    player->update();
-    topRow->update();
-    upperRow->update();
-    lowerRow->update();
-    bottomRow->update();
-    bullets->update();
-    if(explosion->atEnd()) {
-      explosion->isActive = false;
-    }
-    if(explosion->isActive) {
-      explosion->nextFrame();
-      explosion->update();
-    }
+  PROFILE_SCOPE("game::update");
+  updateGraph.run();
 }
 
-void game::draw() {
-    // Set the window title
-    char title[64];
-    std::sprintf(title, "Player Score: %d    |    Lives Remaining: %d", playerScore, playerLives);
-    SDL_SetWindowTitle(SDL::gameWindow, title);
-    
-    // Draw the frame
-    SDL_RenderClear(SDL::renderer);
-    background->draw();
-    tilemap->draw();
-    player->draw();
-    topRow->draw();
-    upperRow->draw();
-    lowerRow->draw();
-    bottomRow->draw();
-    bullets->draw();
-    drawExplosion();
-    SDL_RenderPresent(SDL::renderer);
-    SDL_Delay(20);
-}
-
-void game::drawExplosion() {
-  if(explosion->isActive) { // Check if explosion has been triggered
-    explosion->draw(); 
-  }
+void game::draw(Render::Frame& frame, float alpha) {
+  PROFILE_SCOPE("game::draw");
+    background->draw(frame, alpha);
+    tilemap->draw(frame);
+    Systems::render(*world, frame, Layer::actors, alpha);
+    swarm->draw(frame, alpha);
+    projectiles->draw(frame, alpha);
+    Systems::render(*world, frame, Layer::effects, alpha);
 }
 
 void game::setMenu(int round) {
-  // set logo to point to the proper texture
+  // show the logo for the round
   switch (round) {
     case 1:
-      logo = roundOne;
+      game::showLogo(roundOne);
       break;
     case 2:
-      logo = roundTwo;
+      game::showLogo(roundTwo);
       break;
     case 3:
-      logo = roundThree;
+      game::showLogo(roundThree);
       break;
     default:
-      logo = NULL;
+      game::showLogo(NO_ENTITY);
       break;  
   }
 }
 
-void game::displayMenu(const Uint8* pressedKeys) {
-  // Set the window title
-  char title[64];
-  std::sprintf(title, "Player Score: %d    |    Lives Remaining: %d", playerScore, playerLives);
-  SDL_SetWindowTitle(SDL::gameWindow, title);
-  
-  bool end = false;
+void game::showLogo(Entity next) {
+  if(Sprite* sprite = world->get<Sprite>(logo))
+    sprite->visible = false;
+  logo = next;
+  if(Sprite* sprite = world->get<Sprite>(logo))
+    sprite->visible = true;
+}
+
+void game::movePlayer(Direction direction) {
+  PROFILE_SCOPE("game::movePlayer");
+  Transform* transform = world->get<Transform>(player);
+  const int rightEdge = settings::fieldWidth - world->get<Collider>(player)->width;
+  const int speed = settings::stretch(PLAYER_SPEED);  // Crosses a stretched field as fast as the window
+  transform->position.x = std::clamp(transform->position.x + speed * static_cast<int>(direction), 0, rightEdge);
+}
+
+void game::centerPlayer() {
+  const Collider* collider = world->get<Collider>(player);
+  world->get<Transform>(player)->position = { (settings::fieldWidth - collider->width) / 2, (settings::fieldHeight - collider->height) - 10 };
+  Systems::snap(*world, player);
+}
+
+void game::updateMenu(Uint8 buttons) {
+  PROFILE_SCOPE("game::updateMenu");
   // Check if player presses start
-  if(pressedKeys[SDL_SCANCODE_SPACE]) {
+  // Ignore the key for a moment after a press so one tap doesn't skip two menus
+  if(menuCooldown > 0) {
+    menuCooldown--;
+  }
+  else if(buttons & Replay::FIRE) {
     if(playGame)    // Check if we are entering before game start or before round start
       startRound = true;
     else
       playGame = true;
 
-    SDL_Delay(200);
+    menuCooldown = settings::tickRate / 5;  // Wait 200ms before accepting START again
     // Reset player position
-    player->setLocation({ (settings::SCREEN_WIDTH - player->getWidth()) / 2, (settings::SCREEN_HEIGHT - player->getHeight()) - 10 });
-    end = true;
+    game::centerPlayer();
+    // Stop showing the logo now the menu is done
+    game::showLogo(NO_ENTITY);
   }
 
-  player->nextFrame();
-  player->update();
-  start->nextFrame();
+  Systems::animate(*world);
+  Systems::age(*world);   // Let any explosions left from the round finish
   background->scroll();
-  SDL_RenderClear(SDL::renderer);
-  background->draw();
-  logo->draw();
-  start->draw();
-  player->draw();
-  SDL_RenderPresent(SDL::renderer);
-  if(end) { // Check if we are exiting the function loop
-    // Free up logo memory and assign ptr to NULL
-    delete logo;
-    logo = NULL;
-  }
-  SDL_Delay(20);
+}
+
+void game::drawMenu(Render::Frame& frame, float alpha) {
+  PROFILE_SCOPE("game::drawMenu");
+  background->draw(frame, alpha);
+  Systems::render(*world, frame, Layer::menu, alpha);  // Logo is hidden as soon as the menu is left
+  Systems::render(*world, frame, Layer::actors, alpha);
 }
 
 // SAME AS ABOVE WITHOUT GAME START/ROUND CHECK
+// The simulation thread has finished, so this thread ticks and draws on its own
 void game::displayEnd() {
-  // Set the window title
-  char title[64];
-  std::sprintf(title, "Player Score: %d    |    Lives Remaining: %d", playerScore, playerLives);
-  SDL_SetWindowTitle(SDL::gameWindow, title);
   std::cout << "Final Score: " << playerScore << "\nLives Remaining: " << playerLives << std::endl;
   
+  // Run the end screen for 200 ticks
+  FixedTimestep timestep(settings::tickRate);
+  game::centerPlayer();
+  framePacer.reset();   // The game loop's schedule ended with it
+  Render::Frame frame;
+  frame.score = playerScore;
+  frame.lives = playerLives;
   int count = 0;
   while(count < 200) {
-    player->nextFrame();
-    player->setLocation({ (settings::SCREEN_WIDTH - player->getWidth()) / 2, (settings::SCREEN_HEIGHT - player->getHeight()) - 10 });
-    player->update();
-    background->scroll();
-    SDL_RenderClear(SDL::renderer);
-    background->draw();
-    logo->draw();
-    player->draw();
-    SDL_RenderPresent(SDL::renderer);
-    count++;
-    SDL_Delay(20);
+    timestep.advance();
+    while(timestep.step() && count < 200) {
+      Systems::snapshot(*world);
+      Systems::animate(*world);
+      background->scroll();
+      count++;
+    }
+    game::drawMenu(frame, timestep.alpha());   // Shows the end logo in place of the menu
+    game::present(frame);
+    frame.clear();
+    framePacer.wait();
   }
 }
 
 void game::nextRound() {
+  PROFILE_SCOPE("game::nextRound");
   // Increment round counter and reset newRound flag
   currentRound++;
   newRound = false;
@@ -441,12 +712,74 @@ void game::nextRound() {
   background->scrollSpeed += 2;
 
   //Reset alien location, state, etc
-  topRow->resetRound(currentRound);
-  upperRow->resetRound(currentRound);
-  lowerRow->resetRound(currentRound);
-  bottomRow->resetRound(currentRound);
+  swarm->resetRound(currentRound);
 
 
   // Reset player position
-  player->setLocation({ (settings::SCREEN_WIDTH - player->getWidth()) / 2, (settings::SCREEN_HEIGHT - player->getHeight()) - 10 });
+  game::centerPlayer();
+}
+
+// Put every piece of game state back to how a fresh game starts
+void game::reset() {
+  PROFILE_SCOPE("game::reset");
+  playerScore = 0;
+  playerLives = 3;
+  currentRound = 1;
+  newRound = false;
+  playGame = false;
+  startRound = false;
+  playerWin = false;
+  menuCooldown = 0;
+  bulletTimer = 0;
+  background->scrollSpeed = 3;
+  game::showLogo(titleLogo);
+  world->get<Sprite>(start)->visible = true;
+  Effects::clear(*world);
+  projectiles->clear();
+  swarm->resetRound(currentRound);
+  game::centerPlayer();
+}
+
+// Play games back to back with a simple bot at the controls
+// Ticks run as fast as the CPU allows, then throughput is reported
+// While playing a replay it runs every game in the recording instead
+void game::runHeadless() {
+  Direction botDir = Direction::right;
+  long long totalTicks = 0;
+  long long totalScore = 0;
+  int wins = 0;
+
+  Uint64 startTime = SDL_GetPerformanceCounter();
+  int games = 0;
+  bool replayDone = false;
+  while(Replay::isPlaying() ? !replayDone : games < settings::headlessGames) {
+    if(games > 0)   // Init already set up the first game
+      game::reset();
+    bool running = true;
+    while(running) {
+      // Sweep back and forth across the playfield holding fire
+      const SDL_Rect box = Systems::bounds(*world, player);
+      if(box.x <= 0)
+        botDir = Direction::right;
+      else if(box.x >= settings::fieldWidth - box.w)
+        botDir = Direction::left;
+      Uint8 buttons = Replay::FIRE | (botDir == Direction::left ? Replay::LEFT : Replay::RIGHT);
+
+      Profiler::frame();  // Headless frames are ticks
+      running = game::step(buttons);
+      totalTicks++;
+    }
+    replayDone = Replay::isPlaying() && Replay::finished();
+    if(replayDone && !playerWin && playerLives > 0)   // Recording stopped mid-game, don't count it
+      break;
+    games++;
+    totalScore += playerScore;
+    if(playerWin)
+      wins++;
+  }
+  double seconds = static_cast<double>(SDL_GetPerformanceCounter() - startTime) / SDL_GetPerformanceFrequency();
+
+  std::cout << "Simulated " << games << " games (" << wins << " won, average score "
+            << (games > 0 ? static_cast<double>(totalScore) / games : 0.0) << ")\n";
+  std::cout << totalTicks << " ticks in " << seconds << "s: " << static_cast<long long>(totalTicks / seconds) << " ticks per second" << std::endl;
 }
@@ -0,0 +1,77 @@
+#include "../include/mappedfile.h"
+#include <string>
+#include <cstddef>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile() {
+  close();
+}
+
+bool MappedFile::open(const std::string& path) {
+  close();
+
+#ifdef _WIN32
+  HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+  if(file == INVALID_HANDLE_VALUE)
+    return false;
+  LARGE_INTEGER fileSize;
+  if(!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+    CloseHandle(file);
+    return false;
+  }
+  HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+  void* view = (mapping != NULL) ? MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0) : NULL;
+  if(view == NULL) {
+    if(mapping != NULL)
+      CloseHandle(mapping);
+    CloseHandle(file);
+    return false;
+  }
+  fileHandle = file;
+  mappingHandle = mapping;
+  bytes = static_cast<unsigned char*>(view);
+  length = static_cast<std::size_t>(fileSize.QuadPart);
+#else
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if(fd < 0)
+    return false;
+  struct stat info;
+  if(fstat(fd, &info) != 0 || info.st_size == 0) {
+    ::close(fd);
+    return false;
+  }
+  // Private mapping: pages are shared with the page cache until something writes to them
+  void* view = mmap(nullptr, static_cast<std::size_t>(info.st_size), PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  ::close(fd);  // The mapping keeps its own reference to the file
+  if(view == MAP_FAILED)
+    return false;
+  bytes = static_cast<unsigned char*>(view);
+  length = static_cast<std::size_t>(info.st_size);
+#endif
+  return true;
+}
+
+void MappedFile::close() {
+  if(bytes == nullptr)
+    return;
+#ifdef _WIN32
+  UnmapViewOfFile(bytes);
+  CloseHandle(mappingHandle);
+  CloseHandle(fileHandle);
+  mappingHandle = nullptr;
+  fileHandle = nullptr;
+#else
+  munmap(bytes, length);
+#endif
+  bytes = nullptr;
+  length = 0;
+}
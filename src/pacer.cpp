@@ -0,0 +1,77 @@
+#include "../include/pacer.h"
+#include "../include/profiler.h"
+#include <SDL2/SDL.h>
+#include <algorithm>
+#include <cmath>
+#include <thread>
+#include <iostream>
+
+void FramePacer::setTarget(int fps, bool vsyncOn) {
+  frequency = SDL_GetPerformanceFrequency();
+  period = (fps > 0) ? frequency / static_cast<Uint64>(fps) : 0;
+  spinLength = static_cast<Uint64>(SPIN_SECONDS * frequency);
+  vsync = vsyncOn;
+  reset();
+}
+
+void FramePacer::reset() {
+  released = 0;
+}
+
+// The deadline moves on by whole periods so the schedule never drifts
+// A frame that misses its deadline goes straight out and the schedule starts again from it, rather than rushing frames to catch up
+void FramePacer::wait() {
+  PROFILE_SCOPE("FramePacer::wait");
+  Uint64 now = SDL_GetPerformanceCounter();
+  const bool paced = (period > 0 && !vsync);
+  if(released == 0) {   // First frame of a schedule goes straight out
+    deadline = now;
+  }
+  else if(paced && now > deadline) {
+    missed++;
+    deadline = now;
+  }
+  else if(paced) {
+    // Sleep off all but the last stretch, SDL_Delay only counts whole milliseconds and can wake late
+    if(deadline - now > spinLength) {
+      SDL_Delay(static_cast<Uint32>((deadline - now - spinLength) * 1000 / frequency));
+      now = SDL_GetPerformanceCounter();
+    }
+    // Then spin to the deadline, yielding so the simulation thread still runs on a busy core
+    while(now < deadline) {
+      std::this_thread::yield();
+      now = SDL_GetPerformanceCounter();
+    }
+  }
+  else if(vsync && period > 0 && now - released > period + period / 2) {
+    missed++;   // A refresh went by without a new frame
+  }
+
+  // Measure from release to release
+  if(released != 0) {
+    const double interval = static_cast<double>(now - released);
+    intervals++;
+    intervalSum += interval;
+    intervalSquares += interval * interval;
+    if(period > 0)
+      worstDeviation = std::max(worstDeviation, std::abs(interval - static_cast<double>(period)));
+  }
+  released = now;
+  deadline += period;
+}
+
+void FramePacer::report(std::ostream& out) const {
+  if(intervals == 0)
+    return;
+  const double toMs = 1000.0 / frequency;
+  const double mean = intervalSum / intervals;
+  const double jitter = std::sqrt(std::max(0.0, intervalSquares / intervals - mean * mean));
+  out << "Frame pacing: " << intervals << " frames, " << mean * toMs << "ms average";
+  if(period > 0) {
+    out << " (target " << period * toMs << "ms" << (vsync ? " from vsync" : "") << "), jitter " << jitter * toMs
+        << "ms, worst " << worstDeviation * toMs << "ms off, " << missed << " missed deadlines\n";
+  }
+  else {
+    out << " uncapped, jitter " << jitter * toMs << "ms\n";
+  }
+}
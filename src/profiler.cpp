@@ -0,0 +1,133 @@
+#include "../include/profiler.h"
+#include <SDL2/SDL.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+
+namespace {
+  // One timed scope
+  struct Event {
+    const char* name;
+    Uint64 start;
+    Uint64 end;
+  };
+
+  // Single writer ring of events owned by one thread
+  // The writer fills a slot then publishes it by bumping head, readers only look below head
+  // Once full the oldest events are overwritten
+  struct Ring {
+    static const Uint64 CAPACITY = 1 << 16;   // Power of two so the index is a mask
+    std::vector<Event> events;
+    std::atomic<Uint64> head{ 0 };  // Events ever written
+    int threadId = 0;
+
+    Ring(int id) : events(CAPACITY), threadId{ id } {}
+  };
+
+  // Every thread's ring, kept after the thread exits so its events can still be written out
+  std::mutex registryMutex;
+  std::vector<std::unique_ptr<Ring>> rings;
+  thread_local Ring* localRing = NULL;
+
+  std::string tracePath;
+  int firstFrame = 0;
+  int lastFrame = -1;
+  int currentFrame = -1;
+  bool written = true;    // Nothing to write until a trace is configured
+  Uint64 origin = 0;      // Counter value at the start of the first traced frame
+
+  // Create this thread's ring, only happens on the first recorded scope
+  Ring* registerThread() {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    rings.push_back(std::make_unique<Ring>(static_cast<int>(rings.size()) + 1));
+    return rings.back().get();
+  }
+
+  // Counter ticks to microseconds since the trace began
+  double micros(Uint64 counter) {
+    return static_cast<double>(counter - origin) * 1000000.0 / SDL_GetPerformanceFrequency();
+  }
+
+  // Dump every ring as Chrome trace events
+  void write() {
+    written = true;
+    std::ofstream out(tracePath);
+    if(!out) {
+      std::cout << "Failed to write trace " << tracePath << '\n';
+      return;
+    }
+
+    std::lock_guard<std::mutex> lock(registryMutex);
+    out << "{\"traceEvents\":[\n";
+    bool first = true;
+    long long total = 0;
+    out.setf(std::ios::fixed);
+    out.precision(3);
+    for(const auto& ring : rings) {
+      const Uint64 head = ring->head.load(std::memory_order_acquire);
+      const Uint64 begin = head > Ring::CAPACITY ? head - Ring::CAPACITY : 0;
+      for(Uint64 i = begin; i < head; ++i) {
+        const Event& event = ring->events[i & (Ring::CAPACITY - 1)];
+        if(event.start < origin)
+          continue;
+        out << (first ? "" : ",\n") << "{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << ring->threadId
+            << ",\"ts\":" << micros(event.start) << ",\"dur\":" << micros(event.end) - micros(event.start) << '}';
+        first = false;
+        total++;
+      }
+    }
+    out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+    std::cout << "Wrote " << total << " trace events for frames " << firstFrame << '-' << std::min(lastFrame, currentFrame)
+              << " to " << tracePath << '\n';
+  }
+}
+
+namespace Profiler {
+  std::atomic<bool> recording{ false };
+
+  void record(const char* name, Uint64 start, Uint64 end) {
+    if(localRing == NULL)
+      localRing = registerThread();
+    const Uint64 head = localRing->head.load(std::memory_order_relaxed);
+    localRing->events[head & (Ring::CAPACITY - 1)] = { name, start, end };
+    localRing->head.store(head + 1, std::memory_order_release);   // Publish the event
+  }
+
+  void configure(const std::string& path, int first, int last) {
+    tracePath = path;
+    firstFrame = first;
+    lastFrame = last;
+    written = path.empty();
+#ifndef ENABLE_PROFILER
+    if(!path.empty())
+      std::cout << "Profiler not built in, rebuild with ENABLE_PROFILER to record a trace\n";
+    written = true;
+#endif
+  }
+
+  // Turn recording on and off at the edges of the range
+  // The trace waits for finish, other threads may still be filling their rings when the range ends
+  void frame() {
+    if(written)
+      return;
+    currentFrame++;
+    if(currentFrame == firstFrame) {
+      origin = SDL_GetPerformanceCounter();
+      recording.store(true, std::memory_order_relaxed);
+    }
+    else if(currentFrame == lastFrame + 1) {
+      recording.store(false, std::memory_order_relaxed);
+    }
+  }
+
+  void finish() {
+    recording.store(false, std::memory_order_relaxed);
+    if(!written && currentFrame >= firstFrame)
+      write();
+  }
+}
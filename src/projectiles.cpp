@@ -0,0 +1,292 @@
+#include "../include/projectiles.h"
+#include "../include/profiler.h"
+#include "../include/swarm.h"
+#include "../include/settings.h"
+#include "../include/engine.h"
+#include "../include/atlas.h"
+#include "../include/collide.h"
+#include "../include/effects.h"
+#include "../include/jobs.h"
+#include "../include/types.h"
+#include <algorithm>
+#include <cassert>
+#include <climits>
+#include <string>
+#include <SDL2/SDL.h>
+
+// Static projectile texture
+TextureHandle bulletTextureSheet;
+std::string bulletSheetPath = "graphics/bullet.bmp";
+std::string bulletTransparency = "#000000";
+SDL_Rect bulletSheetSize = { 0, 0, 0, 0 };  // Dimensions of the bullet sheet, filled in by ProjectilePool::init()
+int bulletTimer = 0;   // game::reset starts it again for every game
+
+extern int playerScore;
+extern World* world;
+
+// Initialize static projectile members
+bool ProjectilePool::init(){
+  // Headless runs have no renderer, projectiles take their size from the sheet header
+  if(settings::headless) {
+    if(!SDL::readImageSize(bulletSheetPath, bulletSheetSize.w, bulletSheetSize.h))
+      return false;
+    SDL::bullet_init = true;
+    return true;
+  }
+
+  // Use the packed copy of the sheet if there is one
+  RGB color = hexToRGB(bulletTransparency);
+  Atlas::Region region;
+  if(Atlas::find(bulletSheetPath, color, region)) {
+    bulletTextureSheet = region.texture;
+    bulletSheetSize = region.rect;
+    SDL::bullet_init = true;
+    return true;
+  }
+
+  //Initialize the static bullet texture
+  bulletTextureSheet = Resources::load(bulletSheetPath, color);
+  if(!bulletTextureSheet) {
+    std::cout << "Failed to intitialize static bullet texture!\n";
+    return false;
+  }
+  SDL::FillRect(bulletSheetSize, 0, 0, bulletTextureSheet.getWidth(), bulletTextureSheet.getHeight());
+
+  SDL::bullet_init = true;  // Mark static initialization as completed
+  return true;
+}
+
+// Allocate every slot up front and chain them all into the free list
+ProjectilePool::ProjectilePool(int capacity)
+  : capacity{ std::clamp(capacity, 1, MAX_CAPACITY) },
+    xPos(this->capacity), yPos(this->capacity), xPrev(this->capacity), yPrev(this->capacity),
+    xVelocity(this->capacity), yVelocity(this->capacity), owners(this->capacity), link(this->capacity),
+    grid(CELL_SIZE, settings::fieldWidth, settings::fieldHeight)
+{
+  // Ensure static members have been initialized before building the pool
+  assert((SDL::bullet_init == true) && "Fatal Error: Tried to create projectile pool before initializing static members.");
+
+  width = bulletSheetSize.w;
+  height = bulletSheetSize.h;
+  active.reserve(this->capacity);
+  clear();
+}
+
+// Release every projectile, leaving the free list in slot order
+void ProjectilePool::clear() {
+  active.clear();
+  for(int slot = 0; slot < capacity; ++slot)
+    link[slot] = slot + 1;
+  link[capacity - 1] = NO_SLOT;
+  freeHead = 0;
+}
+
+// Pop a slot off the free list and append it to the active list
+int ProjectilePool::acquire(Owner owner, const Point2d& location, int xSpeed, int ySpeed) {
+  if(freeHead == NO_SLOT)   // Pool is full
+    return NO_SLOT;
+  const int slot = freeHead;
+  freeHead = link[slot];
+
+  xPos[slot] = xPrev[slot] = location.x;  // Start with no interpolation so it doesn't streak
+  yPos[slot] = yPrev[slot] = location.y;
+  xVelocity[slot] = xSpeed;
+  yVelocity[slot] = ySpeed;
+  owners[slot] = owner;
+  link[slot] = static_cast<int>(active.size());
+  active.push_back(slot);
+  return slot;
+}
+
+// Swap the slot out of the active list and push it on the free list
+void ProjectilePool::release(int slot) {
+  const int index = link[slot];
+  const int moved = active.back();  // Last slot in flight fills the hole
+  active[index] = moved;
+  link[moved] = index;
+  active.pop_back();
+
+  link[slot] = freeHead;
+  freeHead = slot;
+}
+
+// Fire a volley from the center of the player's box, a single shot goes straight up
+// Wider volleys fan out evenly up to FAN_SPEED sideways, until the pool runs out of slots
+// Returns false if the fire delay hasn't passed or every slot is in flight
+bool ProjectilePool::fire(const SDL_Rect& shooter) {
+  if(bulletTimer < settings::fireDelay)
+    return false;
+  int xLoc = shooter.x + (shooter.w - width) / 2;
+  int yLoc = shooter.y - height;
+  const int shots = settings::volley;
+  int fired = 0;
+  for(int shot = 0; shot < shots; ++shot) {
+    int xVelocity = (shots > 1) ? (2 * shot - (shots - 1)) * FAN_SPEED / (shots - 1) : 0;
+    if(acquire(Owner::player, { xLoc, yLoc }, xVelocity, -PLAYER_SPEED) == NO_SLOT)
+      break;
+    fired++;
+  }
+  if(fired == 0)
+    return false;
+  bulletTimer = 0;
+  return true;
+}
+
+// Move every projectile, releasing any that leave the playfield
+// Walk the active list backwards so releasing swaps in a slot that was already moved
+void ProjectilePool::update() {
+  PROFILE_SCOPE("ProjectilePool::update");
+  for(int index = static_cast<int>(active.size()) - 1; index >= 0; --index) {
+    const int slot = active[index];
+    xPrev[slot] = xPos[slot];
+    yPrev[slot] = yPos[slot];
+    xPos[slot] += xVelocity[slot];
+    yPos[slot] += yVelocity[slot];
+    if(yPos[slot] <= -height || yPos[slot] >= settings::fieldHeight
+        || xPos[slot] <= -width || xPos[slot] >= settings::fieldWidth)
+      release(slot);
+  }
+}
+
+// Every projectile shares one sheet, so they all replay as a single batch
+void ProjectilePool::draw(Render::Frame& frame, float alpha) {
+  PROFILE_SCOPE("ProjectilePool::draw");
+  SDL_Rect source = { bulletSheetSize.x, bulletSheetSize.y, width, height };
+  SDL_Rect placement = { 0, 0, width, height };
+  SDL_Texture* texture = bulletTextureSheet.get();
+  for(int slot : active) {
+    placement.x = xPrev[slot] + static_cast<int>((xPos[slot] - xPrev[slot]) * alpha);
+    placement.y = yPrev[slot] + static_cast<int>((yPos[slot] - yPrev[slot]) * alpha);
+    frame.add(Layer::projectiles, texture, source, placement);
+  }
+}
+
+// List every alien each player shot overlaps, last shot first
+// Only reads the pool, the swarm and the grid, so chunks can run on any thread at once
+void ProjectilePool::findContacts(const AlienSwarm& swarm, int first, int last, Scratch& scratch, std::vector<Contact>& found) const {
+  PROFILE_SCOPE("ProjectilePool::findContacts");
+  found.clear();
+  for(int index = last - 1; index >= first; --index) {
+    const int slot = active[index];
+    if(owners[slot] != Owner::player)   // Aliens don't shoot each other
+      continue;
+    const SDL_Rect shot = { xPos[slot], yPos[slot], width, height };
+    scratch.candidates.clear();
+    grid.query(shot, scratch.candidates, scratch.query);
+    if(scratch.candidates.empty())
+      continue;
+
+    // Test every candidate at once
+    const int count = static_cast<int>(scratch.candidates.size());
+    scratch.candidateX.resize(count);
+    scratch.candidateY.resize(count);
+    scratch.hitMask.resize(Collide::maskWords(count));
+    for(int c = 0; c < count; ++c) {
+      scratch.candidateX[c] = swarm.xPos[scratch.candidates[c]];
+      scratch.candidateY[c] = swarm.yPos[scratch.candidates[c]];
+    }
+    if(Collide::overlaps(shot, scratch.candidateX.data(), scratch.candidateY.data(), swarm.width, swarm.height, count, scratch.hitMask.data())) {
+      for(int c = 0; c < count; ++c) {
+        if(scratch.hitMask[c / 64] >> (c % 64) & 1)
+          found.push_back({ index, scratch.candidates[c] });
+      }
+    }
+  }
+}
+
+// Check each player shot against the aliens near it
+// Living aliens near the shots are bucketed into a grid, so each shot is only tested against aliens sharing a cell
+// Every hit this tick is scored, each shot can destroy at most one alien
+// The narrowphase is split across threads, the hits are then applied in one fixed order so the result never depends on the thread count
+int ProjectilePool::checkCollisions(AlienSwarm& swarm){
+  PROFILE_SCOPE("ProjectilePool::checkCollisions");
+  if(swarm.isEmpty() || active.empty())  // Nothing to test, skip building the grid
+    return 0;
+
+  // Bound every player shot, aliens outside it can't be hit this tick
+  int left = INT_MAX, top = INT_MAX, right = INT_MIN, bottom = INT_MIN;
+  for(int slot : active) {
+    if(owners[slot] != Owner::player)
+      continue;
+    left = std::min(left, xPos[slot]);
+    top = std::min(top, yPos[slot]);
+    right = std::max(right, xPos[slot] + width);
+    bottom = std::max(bottom, yPos[slot] + height);
+  }
+  if(left > right)   // Only alien shots in flight
+    return 0;
+
+  // Broadphase, bucket the living aliens inside the bounds
+  // A row shares one height, so rows clear of the shots are skipped whole and the cost follows the shots, not the swarm
+  grid.clear();
+  for(int row = 0; row < swarm.rows; ++row) {
+    const int first = row * swarm.columns;
+    const int y = swarm.yPos[first];
+    if(y + swarm.height <= top || y >= bottom)
+      continue;
+    swarm.alive.forEach(first, first + swarm.columns, [&](int j) {
+      if(swarm.xPos[j] + swarm.width > left && swarm.xPos[j] < right)
+        grid.insert(j, { swarm.xPos[j], y, swarm.width, swarm.height });
+    });
+  }
+  grid.build();
+
+  // Narrowphase, each chunk of shots lists the aliens it overlaps
+  const int chunks = Jobs::chunkCount(size(), SHOT_GRAIN);
+  threadScratch.resize(Jobs::threadCount());
+  if(static_cast<int>(contacts.size()) < chunks)
+    contacts.resize(chunks);
+  Jobs::parallelFor(size(), SHOT_GRAIN, [&](int chunk, int first, int last) {
+    findContacts(swarm, first, last, threadScratch[Jobs::threadIndex()], contacts[chunk].found);
+  });
+  for(Scratch& scratch : threadScratch)
+    SpatialHash::tally(scratch.query);
+
+  // Act on the contacts in the order a serial scan would, shots from the back of the active list forward
+  // Releasing a shot only moves shots that were already handled, so the indexes stay good
+  int hits = 0;
+  for(int chunk = chunks - 1; chunk >= 0; --chunk) {
+    const std::vector<Contact>& found = contacts[chunk].found;
+    for(std::size_t c = 0; c < found.size();) {
+      // Take the first alien in swarm order so results match a full scan, skipping any an earlier shot destroyed
+      const int index = found[c].index;
+      int target = -1;
+      for(; c < found.size() && found[c].index == index; ++c) {
+        const int alien = found[c].alien;
+        if(swarm.alive.test(alien) && (target < 0 || alien < target))
+          target = alien;
+      }
+      if(target < 0)
+        continue;
+
+      // Destory the alien
+      swarm.destroy(target);
+      Effects::spawn(*world, EffectType::explosion, { swarm.xPos[target] + swarm.width / 2, swarm.yPos[target] + swarm.height / 2 });
+      // The shot is spent
+      release(active[index]);
+      // increment the score
+      playerScore++;
+      hits++;
+    }
+  }
+  return hits;
+}
+
+// Hash the projectiles in flight, in the order they are updated
+std::uint32_t ProjectilePool::checksum(std::uint32_t hash) const {
+  for(int slot : active) {
+    const int state[4] = { xPos[slot], yPos[slot], xVelocity[slot], yVelocity[slot] };
+    hash = hashBytes(state, sizeof(state), hash);
+  }
+  return hash;
+}
+
+// Print the pool
+std::ostream& operator<<(std::ostream& out, const ProjectilePool& pool) {
+  out << "Projectile Pool: " << pool.active.size() << " / " << pool.capacity << " in flight\n";
+  for(int slot : pool.active) {
+    out << "*Projectile " << slot << ": " << Point2d{ pool.xPos[slot], pool.yPos[slot] }
+        << (pool.owners[slot] == Owner::player ? " Player" : " Alien") << '\n';
+  }
+  return out;
+}
@@ -0,0 +1,34 @@
+#include "../include/random.h"
+#include <cstdint>
+
+Random gameRandom;
+
+// Seed as the PCG reference does, so the same seed gives the same sequence everywhere
+void Random::seed(std::uint64_t seed) {
+  state = 0;
+  next();
+  state += seed;
+  next();
+}
+
+// Advance the LCG, then scramble the old state into the output with a random rotation
+std::uint32_t Random::next() {
+  std::uint64_t old = state;
+  state = old * 6364136223846793005ULL + increment;
+  std::uint32_t shifted = static_cast<std::uint32_t>(((old >> 18u) ^ old) >> 27u);
+  std::uint32_t rotation = static_cast<std::uint32_t>(old >> 59u);
+  return (shifted >> rotation) | (shifted << ((-rotation) & 31));
+}
+
+// Reject the values that would bias the low end, the loop almost never repeats
+int Random::below(int bound) {
+  if(bound <= 1)
+    return 0;
+  std::uint32_t range = static_cast<std::uint32_t>(bound);
+  std::uint32_t threshold = -range % range;
+  for(;;) {
+    std::uint32_t value = next();
+    if(value >= threshold)
+      return static_cast<int>(value % range);
+  }
+}
@@ -0,0 +1,287 @@
+#include "../include/render.h"
+#include "../include/engine.h"
+#include "../include/batch.h"
+#include "../include/profiler.h"
+#include "../include/settings.h"
+#include <algorithm>
+#include <tuple>
+#include <vector>
+#include <chrono>
+#include <mutex>
+#include <condition_variable>
+#include <iostream>
+#include <SDL2/SDL.h>
+
+namespace {
+  const int MAX_DIRTY_RECTS = 32;   // More than this and they are merged into one
+  const double FULL_REDRAW_COVERAGE = 0.6;  // Redraw the whole screen once the dirty rectangles cover this much of it
+
+  SpriteBatch batch;  // Runs of copies from one texture draw in one call
+
+  // Dirty rectangle mode
+  std::vector<Render::Command> lastStatic;    // Background and tile copies last frame
+  std::vector<Render::Command> lastMoving;    // Everything else last frame, sorted by content
+  std::vector<Render::Command> moving;        // The same for this frame
+  std::vector<SDL_Rect> dirty;    // Regions to redraw this frame
+  std::vector<SDL_Rect> invalid;  // Regions changed behind the command lists' backs
+  std::vector<SDL_Rect> windowDirty;  // The dirty regions in window pixels, when the playfield is stretched
+  bool drawnBefore = false;   // Is there a last frame on screen to build on?
+
+  // Totals for reporting
+  long long framesBuilt = 0;    // Published by the simulation
+  long long framesDropped = 0;  // Replaced before the render thread took them
+  long long framesDrawn = 0;
+  long long commandsDrawn = 0;
+  long long rectsDrawn = 0;   // Dirty rectangles redrawn
+  long long pixelsDrawn = 0;  // Area they covered
+
+  SDL_Rect playfield = { 0, 0, settings::SCREEN_WIDTH, settings::SCREEN_HEIGHT };   // Logical area frames are laid out in
+
+  // Layers that come from cached textures and only change between screens
+  bool isStatic(Layer layer) {
+    return layer <= Layer::tiles;
+  }
+
+  // Order commands by everything that shows on screen, so two frames can be compared in one pass
+  auto contents(const Render::Command& command) {
+    return std::tie(command.layer, command.texture, command.placement.x, command.placement.y, command.placement.w, command.placement.h,
+                    command.source.x, command.source.y, command.source.w, command.source.h,
+                    command.color.r, command.color.g, command.color.b, command.color.a);
+  }
+
+  bool byContents(const Render::Command& a, const Render::Command& b) {
+    return contents(a) < contents(b);
+  }
+
+  long long area(const SDL_Rect& rect) {
+    return static_cast<long long>(rect.w) * rect.h;
+  }
+
+  // Grow rectangles together wherever one covering both costs no more than drawing them apart
+  void merge(std::vector<SDL_Rect>& rects) {
+    bool merged = true;
+    while(merged) {
+      merged = false;
+      for(size_t i = 0; i < rects.size(); ++i) {
+        for(size_t j = i + 1; j < rects.size(); ++j) {
+          SDL_Rect both;
+          SDL_UnionRect(&rects[i], &rects[j], &both);
+          if(area(both) > area(rects[i]) + area(rects[j]))
+            continue;
+          rects[i] = both;
+          rects[j] = rects.back();
+          rects.pop_back();
+          merged = true;
+          j = i;  // Check the grown rectangle against everything again
+        }
+      }
+    }
+    if(static_cast<int>(rects.size()) > MAX_DIRTY_RECTS) {
+      SDL_Rect all = rects[0];
+      for(const SDL_Rect& rect : rects)
+        SDL_UnionRect(&all, &rect, &all);
+      rects.assign(1, all);
+    }
+  }
+
+  // Work out what changed since the last frame: the old and new spot of every copy that moved, appeared or went away
+  // A change to the background or tiles, or a window that lost its contents, redraws everything
+  void findDirty(const Render::Frame& frame) {
+    PROFILE_SCOPE("Render::findDirty");
+    dirty.clear();
+    auto firstMoving = std::find_if(frame.commands.begin(), frame.commands.end(), [](const Render::Command& command) { return !isStatic(command.layer); });
+    moving.assign(firstMoving, frame.commands.end());
+    std::sort(moving.begin(), moving.end(), byContents);
+
+    const bool staticSame = std::equal(frame.commands.begin(), firstMoving, lastStatic.begin(), lastStatic.end(),
+      [](const Render::Command& a, const Render::Command& b) { return !byContents(a, b) && !byContents(b, a); });
+    if(!drawnBefore || !staticSame || SDL::windowExposed) {
+      dirty.push_back(playfield);
+    }
+    else {
+      size_t i = 0;
+      size_t j = 0;
+      while(i < lastMoving.size() || j < moving.size()) {
+        if(j == moving.size() || (i < lastMoving.size() && byContents(lastMoving[i], moving[j])))
+          dirty.push_back(lastMoving[i++].placement);   // Gone from where it was
+        else if(i == lastMoving.size() || byContents(moving[j], lastMoving[i]))
+          dirty.push_back(moving[j++].placement);   // Somewhere new
+        else {
+          i++;  // Exactly where it was
+          j++;
+        }
+      }
+      dirty.insert(dirty.end(), invalid.begin(), invalid.end());
+    }
+
+    // Only what is on screen counts
+    size_t kept = 0;
+    for(const SDL_Rect& rect : dirty) {
+      if(SDL_IntersectRect(&rect, &playfield, &dirty[kept]))
+        kept++;
+    }
+    dirty.resize(kept);
+    merge(dirty);
+    long long covered = 0;
+    for(const SDL_Rect& rect : dirty)
+      covered += area(rect);
+    if(covered > FULL_REDRAW_COVERAGE * area(playfield))
+      dirty.assign(1, playfield);
+
+    lastStatic.assign(frame.commands.begin(), firstMoving);
+    lastMoving.swap(moving);
+    invalid.clear();
+    SDL::windowExposed = false;
+    drawnBefore = true;
+  }
+
+  // Window pixels covering part of the playfield, rounded outwards so nothing drawn is left off
+  SDL_Rect toWindow(const SDL_Rect& rect) {
+    auto down = [](int x, int window, int field) { return static_cast<int>(static_cast<long long>(x) * window / field); };
+    auto up = [](int x, int window, int field) { return static_cast<int>((static_cast<long long>(x) * window + field - 1) / field); };
+    const int left = down(rect.x, settings::SCREEN_WIDTH, playfield.w);
+    const int top = down(rect.y, settings::SCREEN_HEIGHT, playfield.h);
+    return { left, top, up(rect.x + rect.w, settings::SCREEN_WIDTH, playfield.w) - left, up(rect.y + rect.h, settings::SCREEN_HEIGHT, playfield.h) - top };
+  }
+
+  // Replay the commands, only those touching the clip rectangle if there is one
+  void replay(const std::vector<Render::Command>& commands, const SDL_Rect* clip) {
+    SDL_Texture* current = NULL;
+    for(const Render::Command& command : commands) {
+      if(clip != NULL && !SDL_HasIntersection(&command.placement, clip))
+        continue;
+      if(command.texture == NULL) {   // Solid fill
+        batch.flush();
+        current = NULL;
+        SDL_SetRenderDrawColor(SDL::renderer, command.color.r, command.color.g, command.color.b, command.color.a);
+        SDL_RenderFillRect(SDL::renderer, &command.placement);
+        SDL_SetRenderDrawColor(SDL::renderer, 0, 0, 0, 255);  // Back to the clear color
+        continue;
+      }
+      if(command.source.w == 0) {   // Whole texture copies go straight through
+        batch.flush();
+        current = NULL;
+        SDL_RenderCopy(SDL::renderer, command.texture, NULL, &command.placement);
+        continue;
+      }
+      if(command.texture != current) {
+        batch.flush();
+        current = command.texture;
+        batch.begin(current);
+      }
+      batch.add(command.source, command.placement);
+    }
+    batch.flush();
+  }
+}
+
+namespace Render {
+  // Lists usually come in layer order already, so they are only sorted when something was added out of turn
+  void draw(Frame& frame) {
+    PROFILE_SCOPE("Render::draw");
+    auto byLayer = [](const Command& a, const Command& b) { return a.layer < b.layer; };
+    if(!std::is_sorted(frame.commands.begin(), frame.commands.end(), byLayer))
+      std::stable_sort(frame.commands.begin(), frame.commands.end(), byLayer);
+    framesDrawn++;
+    commandsDrawn += static_cast<long long>(frame.commands.size());
+
+    if(!settings::dirtyRects) {
+      SDL_RenderClear(SDL::renderer);
+      replay(frame.commands, NULL);
+      PROFILE_SCOPE("SDL_RenderPresent");
+      SDL_RenderPresent(SDL::renderer);
+      return;
+    }
+
+    // Clear and redraw each changed region on its own, then copy just those regions to the window
+    findDirty(frame);
+    if(dirty.empty())
+      return;   // Nothing changed, the window already shows this frame
+    for(const SDL_Rect& rect : dirty) {
+      SDL_RenderSetClipRect(SDL::renderer, &rect);
+      SDL_RenderFillRect(SDL::renderer, &rect);   // Clearing ignores the clip rectangle
+      replay(frame.commands, &rect);
+      rectsDrawn++;
+      pixelsDrawn += area(rect);
+    }
+    SDL_RenderSetClipRect(SDL::renderer, NULL);
+    PROFILE_SCOPE("SDL_UpdateWindowSurfaceRects");
+    SDL_RenderFlush(SDL::renderer);
+    if(playfield.w == settings::SCREEN_WIDTH && playfield.h == settings::SCREEN_HEIGHT) {
+      SDL_UpdateWindowSurfaceRects(SDL::gameWindow, dirty.data(), static_cast<int>(dirty.size()));
+      return;
+    }
+    windowDirty.clear();
+    for(const SDL_Rect& rect : dirty)
+      windowDirty.push_back(toWindow(rect));
+    SDL_UpdateWindowSurfaceRects(SDL::gameWindow, windowDirty.data(), static_cast<int>(windowDirty.size()));
+  }
+
+  void fitField() {
+    playfield = { 0, 0, settings::fieldWidth, settings::fieldHeight };
+    drawnBefore = false;  // Everything on screen moves
+    if(playfield.w != settings::SCREEN_WIDTH || playfield.h != settings::SCREEN_HEIGHT)
+      SDL_RenderSetLogicalSize(SDL::renderer, playfield.w, playfield.h);
+  }
+
+  SDL_Rect stretch(const SDL_Rect& rect) {
+    const int left = settings::stretch(rect.x);
+    const int top = settings::stretch(rect.y);
+    return { left, top, settings::stretch(rect.x + rect.w) - left, settings::stretch(rect.y + rect.h) - top };
+  }
+
+  void invalidate(const SDL_Rect& rect) {
+    invalid.push_back(rect);
+  }
+
+  void report(std::ostream& out) {
+    out << "Render: " << framesDrawn << " frames drawn";
+    if(framesDrawn > 0)
+      out << " (" << commandsDrawn / framesDrawn << " commands per frame)";
+    out << ", " << framesDropped << " of " << framesBuilt << " frames from the simulation replaced before they were drawn\n";
+    if(settings::dirtyRects && framesDrawn > 0) {
+      out << "Dirty rectangles: " << static_cast<double>(rectsDrawn) / framesDrawn << " per frame, redrawing "
+          << 100.0 * pixelsDrawn / (static_cast<double>(framesDrawn) * area(playfield)) << "% of the screen\n";
+    }
+  }
+}
+
+// Swap the finished frame into the middle slot
+void FrameQueue::publish() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::swap(writing, ready);
+    if(fresh)
+      framesDropped++;
+    fresh = true;
+    framesBuilt++;
+  }
+  changed.notify_all();
+  frames[writing].clear();
+}
+
+// Swap the newest frame out of the middle slot, the one just drawn goes back to be reused
+Render::Frame* FrameQueue::acquire(int timeoutMs) {
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    if(!changed.wait_for(lock, std::chrono::milliseconds(timeoutMs), [this] { return fresh || closed; }) || !fresh)
+      return NULL;
+    std::swap(reading, ready);
+    fresh = false;
+  }
+  changed.notify_all();
+  return &frames[reading];
+}
+
+void FrameQueue::waitTaken(int timeoutMs) {
+  std::unique_lock<std::mutex> lock(mutex);
+  changed.wait_for(lock, std::chrono::milliseconds(timeoutMs), [this] { return !fresh || closed; });
+}
+
+void FrameQueue::close() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    closed = true;
+  }
+  changed.notify_all();
+}
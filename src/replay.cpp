@@ -0,0 +1,180 @@
+#include "../include/replay.h"
+#include "../include/settings.h"
+#include "../include/projectiles.h"
+#include <SDL2/SDL.h>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <iostream>
+
+namespace {
+  const char MAGIC[4] = { 'R', 'P', 'L', 'Y' };
+  const std::uint16_t VERSION = 2;
+  const std::uint16_t VERSION_SEED_ONLY = 1;  // Older files without the gameplay settings, played with whatever is set
+  const std::size_t HEADER_SIZE = 48;
+  const std::size_t SEED_ONLY_HEADER_SIZE = 16;
+  const std::size_t TICK_SIZE = 5;
+
+  // Recording state, ticks are written as they happen so a crash still leaves a usable file
+  std::ofstream recording;
+
+  // Playback state
+  bool playing = false;
+  std::vector<unsigned char> ticks;   // Raw tick records
+  std::size_t tickCount = 0;
+  std::size_t played = 0;   // Ticks handed out so far
+  std::size_t verified = 0;   // Ticks whose hash matched
+  long long firstMismatch = -1;   // First tick that diverged, -1 if none has
+
+  void put16(unsigned char* out, std::uint16_t value) {
+    out[0] = value & 0xff;
+    out[1] = value >> 8;
+  }
+  void put32(unsigned char* out, std::uint32_t value) {
+    for(int i = 0; i < 4; ++i)
+      out[i] = (value >> (8 * i)) & 0xff;
+  }
+  std::uint32_t get32(const unsigned char* in) {
+    return in[0] | (in[1] << 8) | (in[2] << 16) | (static_cast<std::uint32_t>(in[3]) << 24);
+  }
+
+  // Every setting that changes how a game plays out, in the order they are stored after the seed
+  int* const GAMEPLAY_SETTINGS[] = {
+    &settings::projectileCapacity, &settings::swarmRows, &settings::swarmColumns, &settings::swarmGap,
+    &settings::swarmGutter, &settings::swarmSpeed, &settings::volley, &settings::fireDelay
+  };
+  const int GAMEPLAY_SETTING_COUNT = sizeof(GAMEPLAY_SETTINGS) / sizeof(GAMEPLAY_SETTINGS[0]);
+  static_assert(SEED_ONLY_HEADER_SIZE + GAMEPLAY_SETTING_COUNT * 4 == HEADER_SIZE, "Replay header size is out of date");
+
+  // Only take settings the command line could have set, a damaged header shouldn't size the swarm
+  bool sane(const int (&values)[GAMEPLAY_SETTING_COUNT]) {
+    const int projectiles = values[0], rows = values[1], columns = values[2], gap = values[3];
+    const int gutter = values[4], speed = values[5], volley = values[6], fireDelay = values[7];
+    return projectiles >= 1 && projectiles <= ProjectilePool::MAX_CAPACITY && rows >= 1 && rows <= 1000 && columns >= 1 && columns <= 1000
+        && gap >= 0 && gutter >= 0 && speed >= 1 && volley >= 1 && volley <= projectiles && fireDelay >= 1;
+  }
+}
+
+namespace Replay {
+  Uint8 readKeyboard(const Uint8* keys) {
+    Uint8 buttons = 0;
+    if(keys[SDL_SCANCODE_LEFT])
+      buttons |= LEFT;
+    if(keys[SDL_SCANCODE_RIGHT])
+      buttons |= RIGHT;
+    if(keys[SDL_SCANCODE_SPACE])
+      buttons |= FIRE;
+    return buttons;
+  }
+
+  bool startRecording(const std::string& path, std::uint64_t seed, int tickRate) {
+    recording.open(path, std::ios::binary | std::ios::trunc);
+    if(!recording) {
+      std::cout << "Unable to record replay to " << path << '\n';
+      return false;
+    }
+    unsigned char header[HEADER_SIZE];
+    std::memcpy(header, MAGIC, 4);
+    put16(header + 4, VERSION);
+    put16(header + 6, static_cast<std::uint16_t>(tickRate));
+    put32(header + 8, static_cast<std::uint32_t>(seed));
+    put32(header + 12, static_cast<std::uint32_t>(seed >> 32));
+    for(int i = 0; i < GAMEPLAY_SETTING_COUNT; ++i)
+      put32(header + SEED_ONLY_HEADER_SIZE + 4 * i, static_cast<std::uint32_t>(*GAMEPLAY_SETTINGS[i]));
+    recording.write(reinterpret_cast<const char*>(header), HEADER_SIZE);
+    return true;
+  }
+
+  void record(Uint8 buttons, std::uint32_t stateHash) {
+    if(!recording.is_open())
+      return;
+    unsigned char tick[TICK_SIZE];
+    tick[0] = buttons;
+    put32(tick + 1, stateHash);
+    recording.write(reinterpret_cast<const char*>(tick), TICK_SIZE);
+  }
+
+  void stopRecording() {
+    if(recording.is_open())
+      recording.close();
+  }
+
+  bool isRecording() {
+    return recording.is_open();
+  }
+
+  // The tick count comes from the file size, so a recording cut short by a crash still plays
+  // The recorded gameplay settings replace the ones given, so the game plays out as it was recorded
+  bool load(const std::string& path, std::uint64_t& seed, int& tickRate) {
+    std::ifstream in(path, std::ios::binary);
+    std::vector<unsigned char> data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    const int version = data.size() >= 6 ? (data[4] | (data[5] << 8)) : 0;
+    const std::size_t headerSize = (version == VERSION_SEED_ONLY) ? SEED_ONLY_HEADER_SIZE : HEADER_SIZE;
+    if(data.size() < headerSize || std::memcmp(data.data(), MAGIC, 4) != 0 || (version != VERSION && version != VERSION_SEED_ONLY)) {
+      std::cout << "Not a replay file: " << path << '\n';
+      return false;
+    }
+    if(version == VERSION) {
+      int values[GAMEPLAY_SETTING_COUNT];
+      for(int i = 0; i < GAMEPLAY_SETTING_COUNT; ++i)
+        values[i] = static_cast<int>(get32(&data[SEED_ONLY_HEADER_SIZE + 4 * i]));
+      if(!sane(values)) {
+        std::cout << "Replay has settings out of range: " << path << '\n';
+        return false;
+      }
+      for(int i = 0; i < GAMEPLAY_SETTING_COUNT; ++i)
+        *GAMEPLAY_SETTINGS[i] = values[i];
+    }
+    tickRate = data[6] | (data[7] << 8);
+    seed = get32(&data[8]) | (static_cast<std::uint64_t>(get32(&data[12])) << 32);
+    ticks.assign(data.begin() + headerSize, data.end());
+    tickCount = ticks.size() / TICK_SIZE;
+    played = verified = 0;
+    firstMismatch = -1;
+    playing = true;
+    return true;
+  }
+
+  bool isPlaying() {
+    return playing;
+  }
+
+  bool next(Uint8& buttons) {
+    if(!playing || played >= tickCount)
+      return false;
+    buttons = ticks[played * TICK_SIZE];
+    played++;
+    return true;
+  }
+
+  bool finished() {
+    return played >= tickCount;
+  }
+
+  // Once a tick diverges everything after it will too, so only the first is reported
+  void verify(std::uint32_t stateHash) {
+    if(!playing || played == 0 || firstMismatch >= 0)
+      return;
+    const std::size_t tick = played - 1;
+    if(get32(&ticks[tick * TICK_SIZE + 1]) == stateHash) {
+      verified++;
+    }
+    else {
+      firstMismatch = static_cast<long long>(tick);
+      std::cout << "Replay diverged at tick " << tick << '\n';
+    }
+  }
+
+  void report(std::ostream& out) {
+    if(!playing)
+      return;
+    out << "Replay: played " << played << " of " << tickCount << " ticks, " << verified << " matched";
+    if(firstMismatch >= 0)
+      out << ", diverged at tick " << firstMismatch;
+    else if(played == tickCount)
+      out << ", deterministic";
+    out << '\n';
+  }
+}
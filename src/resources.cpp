@@ -0,0 +1,198 @@
+#include "../include/resources.h"
+#include "../include/engine.h"
+#include "../include/types.h"
+#include "../include/loader.h"
+#include "../include/archive.h"
+#include <SDL2/SDL.h>
+#include <string>
+#include <memory>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+
+namespace Resources {
+  std::unordered_map<std::string, std::shared_ptr<Texture>> cache;  // Every texture we hold, by key
+  std::size_t budget = 256 * 1024 * 1024;   // Default budget of 256MB
+  std::size_t used = 0;
+  unsigned long long clock = 0;   // Stamp source for LRU ordering
+  int loads = 0;    // Loads that went to disk
+  int hits = 0;     // Loads served from the cache
+
+  // Is the cache the only thing holding this texture?
+  static bool unreferenced(const std::shared_ptr<Texture>& entry) {
+    return entry.use_count() == 1;
+  }
+
+  static void release(Texture& entry) {
+    SDL_DestroyTexture(entry.texture);
+    entry.texture = NULL;
+    used -= entry.bytes;
+  }
+
+  // Free least recently used, unreferenced textures until we fit the budget
+  static void enforceBudget() {
+    if(used <= budget)
+      return;
+
+    std::vector<std::shared_ptr<Texture>> candidates;
+    for(auto& [key, entry] : cache) {
+      if(unreferenced(entry))
+        candidates.push_back(entry);
+    }
+    std::sort(candidates.begin(), candidates.end(), [](const auto& a, const auto& b) { return a->lastUsed < b->lastUsed; });
+
+    for(auto& entry : candidates) {
+      if(used <= budget)
+        break;
+      release(*entry);
+      cache.erase(entry->key);
+    }
+    if(used > budget)
+      std::cout << "Texture memory " << used / 1024 << "KB is over budget, everything left is in use\n";
+  }
+
+  // Add a texture to the cache and account for its memory
+  static TextureHandle insert(const std::string& key, SDL_Texture* texture) {
+    auto entry = std::make_shared<Texture>();
+    entry->key = key;
+    entry->texture = texture;
+    entry->lastUsed = ++clock;
+    Uint32 format = SDL_PIXELFORMAT_UNKNOWN;
+    SDL_QueryTexture(texture, &format, NULL, &entry->width, &entry->height);
+    int bytesPerPixel = (format == SDL_PIXELFORMAT_UNKNOWN) ? 4 : SDL_BYTESPERPIXEL(format);
+    entry->bytes = static_cast<std::size_t>(entry->width) * entry->height * bytesPerPixel;
+    used += entry->bytes;
+    cache[key] = entry;
+
+    TextureHandle handle(entry);  // Hold a reference so the new texture can't be evicted
+    enforceBudget();
+    return handle;
+  }
+
+  // Hand out the cached texture for a key, if we have it
+  static bool lookup(const std::string& key, TextureHandle& handle) {
+    auto found = cache.find(key);
+    if(found == cache.end())
+      return false;
+    found->second->lastUsed = ++clock;
+    hits++;
+    handle = TextureHandle(found->second);
+    return true;
+  }
+
+  // Key on the path and the color key, the same image keyed differently is a different texture
+  static std::string keyFor(const std::string& path, const RGB* transparency) {
+    std::string key = path;
+    if(transparency != NULL) {
+      char color[8];
+      std::snprintf(color, sizeof(color), "#%02x%02x%02x", transparency->r, transparency->g, transparency->b);
+      key += color;
+    }
+    return key;
+  }
+
+  // Decode a bitmap and apply its color key, safe on any thread
+  // Images cooked into the asset archive with the same key are used in place, already converted
+  static SDL_Surface* decode(const std::string& path, const RGB* transparency) {
+    const assetformat::Entry* cooked = Archive::find(path);
+    if(cooked != NULL && cooked->kind == assetformat::IMAGE && Archive::matches(*cooked, transparency))
+      return Archive::surface(*cooked);
+    SDL_Surface* surface = SDL::loadImage(path);
+    if(surface != NULL && transparency != NULL)
+      SDL::setTransparentColor(surface, transparency->r, transparency->g, transparency->b);
+    return surface;
+  }
+
+  static TextureHandle loadKeyed(const std::string& path, const RGB* transparency) {
+    const std::string key = keyFor(path, transparency);
+    TextureHandle handle;
+    if(lookup(key, handle))
+      return handle;
+
+    SDL_Surface* surface = decode(path, transparency);
+    if(surface == NULL)
+      return TextureHandle();
+    SDL_Texture* texture = SDL::loadTexture(surface);
+    if(texture == NULL)
+      return TextureHandle();
+    loads++;
+    return insert(key, texture);
+  }
+
+  // The upload is skipped if the texture was loaded some other way in the meantime
+  static void preloadKeyed(const std::string& path, const RGB* transparency) {
+    const std::string key = keyFor(path, transparency);
+    if(cache.count(key) > 0)
+      return;
+    const bool keyed = (transparency != NULL);
+    const RGB color = keyed ? *transparency : RGB{};
+    Loader::request(path,
+      [path, keyed, color] { return decode(path, keyed ? &color : NULL); },
+      [key](SDL_Surface* surface) {
+        if(cache.count(key) > 0)
+          return true;
+        SDL_Texture* texture = SDL_CreateTextureFromSurface(SDL::renderer, surface);
+        if(texture == NULL)
+          return false;
+        loads++;
+        insert(key, texture);
+        return true;
+      });
+  }
+
+  TextureHandle load(const std::string& path) {
+    return loadKeyed(path, NULL);
+  }
+
+  TextureHandle load(const std::string& path, const RGB& transparency) {
+    return loadKeyed(path, &transparency);
+  }
+
+  void preload(const std::string& path) {
+    preloadKeyed(path, NULL);
+  }
+
+  void preload(const std::string& path, const RGB& transparency) {
+    preloadKeyed(path, &transparency);
+  }
+
+  TextureHandle peek(const std::string& path) {
+    auto found = cache.find(path);
+    return found == cache.end() ? TextureHandle() : TextureHandle(found->second);
+  }
+
+  TextureHandle adopt(const std::string& key, SDL_Texture* texture) {
+    auto found = cache.find(key);
+    if(found != cache.end()) {  // Replacing an old texture under the same key
+      if(found->second->texture != texture)
+        release(*found->second);
+      else
+        used -= found->second->bytes;
+      cache.erase(found);
+    }
+    return insert(key, texture);
+  }
+
+  void setBudget(std::size_t bytes) {
+    budget = bytes;
+    enforceBudget();
+  }
+
+  void report(std::ostream& out) {
+    out << "Texture memory: " << used / 1024 << "KB of " << budget / 1024 << "KB budget, "
+        << cache.size() << " textures (" << loads << " loaded, " << hits << " shared)\n";
+    for(auto& [key, entry] : cache) {
+      out << "  " << key << ": " << entry->width << 'x' << entry->height << ", "
+          << entry->bytes / 1024 << "KB, " << entry.use_count() - 1 << " refs\n";
+    }
+  }
+
+  void shutdown() {
+    // Handles that outlive us just see a NULL texture
+    for(auto& [key, entry] : cache)
+      release(*entry);
+    cache.clear();
+  }
+}
@@ -0,0 +1,246 @@
+#include "../include/settings.h"
+#include "../include/projectiles.h"
+#include <cstdlib>
+#include <cctype>
+#include <algorithm>
+#include <cstdio>
+#include <ctime>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+
+namespace settings {
+  // Default runtime options
+  int tickRate = 50;    // 50 ticks per second matches the original 20ms frame delay
+  int maxFps = 120;
+  bool vsync = false;
+  bool headless = false;
+  int headlessGames = 1;
+  int textureBudgetMB = 256;
+  int projectileCapacity = 64;
+  std::string traceFile = "";
+  int traceFirstFrame = 0;
+  int traceLastFrame = 299;
+  std::uint64_t seed = static_cast<std::uint64_t>(std::time(0));
+  std::string recordFile = "";
+  std::string replayFile = "";
+  bool replayFast = false;
+  int threads = 0;
+  bool dirtyRects = false;
+  int swarmRows = 4;
+  int swarmColumns = 10;
+  int swarmGap = 20;
+  int swarmGutter = 210;
+  int swarmSpeed = 1;
+  int volley = 1;
+  int fireDelay = 40;
+  int fieldWidth = SCREEN_WIDTH;    // Fitted to the swarm once the alien size is known
+  int fieldHeight = SCREEN_HEIGHT;
+
+  namespace {
+    // Named scenarios, written the same way as a config file
+    // Later options still override them, so "--preset swarm-100 --swarm-speed 2" slows the big swarm down
+    struct Preset {
+      const char* name;
+      const char* options;
+    };
+    const Preset PRESETS[] = {
+      { "classic", "swarm 4x10\ngap 20\ngutter 210\nswarm-speed 1\nvolley 1\nfire-delay 40\nprojectiles 64\n" },
+      { "swarm-100", "swarm 100x100\ngap 8\nprojectiles 1024\n" },     // Ten thousand aliens
+      { "swarm-1000", "swarm 1000x1000\ngap 8\nprojectiles 4096\n" },  // A million aliens
+      { "bullets", "swarm 20x40\ngap 8\nvolley 100\nfire-delay 2\nprojectiles 16384\n" }  // Thousands of shots in flight
+    };
+
+    bool parseOptions(const std::vector<std::string>& args, const std::string& source);
+
+    // Turn "option value" lines into command line options, skipping blanks and # comments
+    // Reading from a stream lets presets share the config file format
+    bool parseLines(std::istream& in, const std::string& source) {
+      std::vector<std::string> args;
+      std::string line;
+      while(std::getline(in, line)) {
+        line = line.substr(0, line.find('#'));
+        std::istringstream words(line);
+        std::string option;
+        if(!(words >> option))
+          continue;
+        if(option == "config") {
+          std::cout << "Config files can't include other config files: " << source << '\n';
+          return false;
+        }
+        args.push_back("--" + option);
+        std::string value;
+        std::getline(words >> std::ws, value);  // The rest of the line, so paths can hold spaces
+        while(!value.empty() && std::isspace(static_cast<unsigned char>(value.back())))
+          value.pop_back();
+        if(!value.empty())
+          args.push_back(value);
+      }
+      return parseOptions(args, source);
+    }
+
+    bool loadConfig(const std::string& path) {
+      std::ifstream in(path);
+      if(!in) {
+        std::cout << "Unable to open config file: " << path << '\n';
+        return false;
+      }
+      return parseLines(in, path);
+    }
+
+    bool applyPreset(const std::string& name) {
+      for(const Preset& preset : PRESETS) {
+        if(name == preset.name) {
+          std::istringstream in(preset.options);
+          return parseLines(in, "preset " + name);
+        }
+      }
+      std::cout << "Unknown preset: " << name << ", expected one of";
+      for(const Preset& preset : PRESETS)
+        std::cout << ' ' << preset.name;
+      std::cout << '\n';
+      return false;
+    }
+
+    // Apply options in order, each taking the value after it if it needs one
+    // Returns false if an option was not understood
+    bool parseOptions(const std::vector<std::string>& args, const std::string& source) {
+      const int count = static_cast<int>(args.size());
+      for(int i = 0; i < count; ++i) {
+        const std::string& arg = args[i];
+        bool hasValue = (i + 1 < count);  // Does the option have a following value?
+
+        if(arg == "--tick-rate" && hasValue) {
+          tickRate = std::atoi(args[++i].c_str());
+        }
+        else if(arg == "--max-fps" && hasValue) {
+          maxFps = std::atoi(args[++i].c_str());
+        }
+        else if(arg == "--vsync") {
+          vsync = true;
+        }
+        else if(arg == "--headless") {
+          headless = true;
+        }
+        else if(arg == "--games" && hasValue) {
+          headlessGames = std::atoi(args[++i].c_str());
+        }
+        else if(arg == "--texture-budget" && hasValue) {
+          textureBudgetMB = std::atoi(args[++i].c_str());
+        }
+        else if(arg == "--projectiles" && hasValue) {
+          projectileCapacity = std::atoi(args[++i].c_str());
+        }
+        else if(arg == "--trace" && hasValue) {
+          traceFile = args[++i];
+        }
+        else if(arg == "--trace-frames" && hasValue) {   // Range written as FIRST-LAST
+          if(std::sscanf(args[++i].c_str(), "%d-%d", &traceFirstFrame, &traceLastFrame) != 2) {
+            std::cout << "Expected a frame range like 100-200, got " << args[i] << '\n';
+            return false;
+          }
+        }
+        else if(arg == "--seed" && hasValue) {
+          seed = std::strtoull(args[++i].c_str(), NULL, 10);
+        }
+        else if(arg == "--record" && hasValue) {
+          recordFile = args[++i];
+        }
+        else if(arg == "--replay" && hasValue) {
+          replayFile = args[++i];
+        }
+        else if(arg == "--replay-fast") {
+          replayFast = true;
+        }
+        else if(arg == "--threads" && hasValue) {
+          threads = std::atoi(args[++i].c_str());
+        }
+        else if(arg == "--dirty-rects") {
+          dirtyRects = true;
+        }
+        else if(arg == "--swarm" && hasValue) {   // Size written as ROWSxCOLUMNS
+          if(std::sscanf(args[++i].c_str(), "%dx%d", &swarmRows, &swarmColumns) != 2) {
+            std::cout << "Expected a swarm size like 4x10, got " << args[i] << '\n';
+            return false;
+          }
+        }
+        else if(arg == "--gap" && hasValue) {
+          swarmGap = std::atoi(args[++i].c_str());
+        }
+        else if(arg == "--gutter" && hasValue) {
+          swarmGutter = std::atoi(args[++i].c_str());
+        }
+        else if(arg == "--swarm-speed" && hasValue) {
+          swarmSpeed = std::atoi(args[++i].c_str());
+        }
+        else if(arg == "--volley" && hasValue) {
+          volley = std::atoi(args[++i].c_str());
+        }
+        else if(arg == "--fire-delay" && hasValue) {
+          fireDelay = std::atoi(args[++i].c_str());
+        }
+        else if(arg == "--preset" && hasValue) {
+          if(!applyPreset(args[++i]))
+            return false;
+        }
+        else if(arg == "--config" && hasValue) {
+          if(!loadConfig(args[++i]))
+            return false;
+        }
+        else {
+          if(source.empty())
+            std::cout << "Unknown option: " << arg << '\n';
+          else
+            std::cout << "Unknown option in " << source << ": " << arg.substr(2) << '\n';
+          return false;
+        }
+      }
+      return true;
+    }
+  }
+
+  // Parse command line options into the runtime settings
+  // Returns false if an option was not understood
+  bool parseArgs(int argc, char* argv[]) {
+    if(!parseOptions(std::vector<std::string>(argv + 1, argv + argc), ""))
+      return false;
+
+    // Clamp to sane values
+    if(tickRate < 1)
+      tickRate = 1;
+    if(maxFps < 0)
+      maxFps = 0;
+    if(headlessGames < 1)
+      headlessGames = 1;
+    if(textureBudgetMB < 1)
+      textureBudgetMB = 1;
+    if(projectileCapacity < 1)
+      projectileCapacity = 1;
+    if(projectileCapacity > ProjectilePool::MAX_CAPACITY)
+      projectileCapacity = ProjectilePool::MAX_CAPACITY;
+    if(threads < 0)
+      threads = 0;
+    if(traceFirstFrame < 0)
+      traceFirstFrame = 0;
+    if(traceLastFrame < traceFirstFrame)
+      traceLastFrame = traceFirstFrame;
+    swarmRows = std::clamp(swarmRows, 1, 1000);   // A million aliens is as far as the stress presets go
+    swarmColumns = std::clamp(swarmColumns, 1, 1000);
+    if(swarmGap < 0)
+      swarmGap = 0;
+    if(swarmGutter < 0)
+      swarmGutter = 0;
+    if(swarmSpeed < 1)
+      swarmSpeed = 1;
+    volley = std::clamp(volley, 1, projectileCapacity);
+    if(fireDelay < 1)
+      fireDelay = 1;
+    return true;
+  }
+
+  int stretch(int length) {
+    return static_cast<int>(static_cast<long long>(length) * fieldWidth / SCREEN_WIDTH);
+  }
+}
@@ -0,0 +1,136 @@
+#include "../include/spatialhash.h"
+#include "../include/profiler.h"
+#include <SDL2/SDL.h>
+#include <algorithm>
+#include <vector>
+#include <iostream>
+
+long long SpatialHash::candidatesFound = 0;
+long long SpatialHash::queriesRun = 0;
+
+// Create an empty grid covering the given area
+// Anything outside the area is clamped into the edge cells, so it is still found
+SpatialHash::SpatialHash(int cellSize, int width, int height)
+  : cellSize{ std::max(cellSize, 1) }
+{
+  columns = std::max((width + this->cellSize - 1) / this->cellSize, 1);
+  rows = std::max((height + this->cellSize - 1) / this->cellSize, 1);
+  cellCount.assign(columns * rows, 0);
+  cellStart.assign(columns * rows, 0);
+  cellNext.assign(columns * rows, 0);
+}
+
+// Drop every item, keeping the storage for the next tick
+void SpatialHash::clear() {
+  pendingIds.clear();
+  pendingBoxes.clear();
+  cellItems.clear();
+  for(int cell : touched)
+    cellCount[cell] = 0;
+  touched.clear();
+}
+
+// Queue an item to be bucketed on the next build
+void SpatialHash::insert(int id, const SDL_Rect& box) {
+  pendingIds.push_back(id);
+  pendingBoxes.push_back(box);
+  idLimit = std::max(idLimit, id + 1);
+}
+
+// Find the cells a box overlaps, clamped to the grid
+void SpatialHash::cellRange(const SDL_Rect& box, int& firstCol, int& firstRow, int& lastCol, int& lastRow) const {
+  auto cell = [this](int pixel, int limit) {
+    int index = pixel >= 0 ? pixel / cellSize : -1;
+    return std::clamp(index, 0, limit - 1);
+  };
+  firstCol = cell(box.x, columns);
+  firstRow = cell(box.y, rows);
+  lastCol = cell(box.x + box.w - 1, columns);
+  lastRow = cell(box.y + box.h - 1, rows);
+}
+
+// Bucket every queued item
+// First count the items per cell, then turn the counts into offsets and scatter the ids into place
+// Only cells that got an item are visited, in the order they were first touched
+void SpatialHash::build() {
+  PROFILE_SCOPE("SpatialHash::build");
+  for(int cell : touched)   // Built before without a clear
+    cellCount[cell] = 0;
+  touched.clear();
+
+  int firstCol, firstRow, lastCol, lastRow;
+  for(const SDL_Rect& box : pendingBoxes) {
+    cellRange(box, firstCol, firstRow, lastCol, lastRow);
+    for(int row = firstRow; row <= lastRow; ++row) {
+      for(int col = firstCol; col <= lastCol; ++col) {
+        const int cell = row * columns + col;
+        if(cellCount[cell]++ == 0)
+          touched.push_back(cell);
+      }
+    }
+  }
+  int total = 0;  // Running total gives where each cell begins
+  for(int cell : touched) {
+    cellStart[cell] = cellNext[cell] = total;
+    total += cellCount[cell];
+  }
+
+  cellItems.resize(total);
+  for(size_t i = 0; i < pendingIds.size(); ++i) {
+    cellRange(pendingBoxes[i], firstCol, firstRow, lastCol, lastRow);
+    for(int row = firstRow; row <= lastRow; ++row)
+      for(int col = firstCol; col <= lastCol; ++col)
+        cellItems[cellNext[row * columns + col]++] = pendingIds[i];
+  }
+}
+
+// Collect every item sharing a cell with the area
+// Items come back grouped by cell, each one only once
+void SpatialHash::query(const SDL_Rect& area, std::vector<int>& found) {
+  query(area, found, state);
+  tally(state);
+}
+
+// The grid is only read, everything a query writes lives in the scratch
+void SpatialHash::query(const SDL_Rect& area, std::vector<int>& found, QueryState& scratch) const {
+  scratch.queries++;
+  if(static_cast<int>(scratch.lastSeen.size()) < idLimit)
+    scratch.lastSeen.resize(idLimit, 0);
+  if(++scratch.stamp == 0) {   // Stamp wrapped, forget the old ones
+    std::fill(scratch.lastSeen.begin(), scratch.lastSeen.end(), 0);
+    scratch.stamp = 1;
+  }
+
+  const size_t before = found.size();
+  int firstCol, firstRow, lastCol, lastRow;
+  cellRange(area, firstCol, firstRow, lastCol, lastRow);
+  for(int row = firstRow; row <= lastRow; ++row) {
+    for(int col = firstCol; col <= lastCol; ++col) {
+      const int cell = row * columns + col;
+      const int end = cellStart[cell] + cellCount[cell];
+      for(int i = cellStart[cell]; i < end; ++i) {
+        const int id = cellItems[i];
+        if(scratch.lastSeen[id] != scratch.stamp) {
+          scratch.lastSeen[id] = scratch.stamp;
+          found.push_back(id);
+        }
+      }
+    }
+  }
+  scratch.candidates += found.size() - before;
+}
+
+void SpatialHash::tally(QueryState& scratch) {
+  queriesRun += scratch.queries;
+  candidatesFound += scratch.candidates;
+  scratch.queries = 0;
+  scratch.candidates = 0;
+}
+
+// Print totals for every query made so far
+void SpatialHash::report(std::ostream& out) {
+  out << "Broadphase: " << queriesRun << " queries returned " << candidatesFound << " candidates";
+  if(queriesRun > 0)
+    out << " (" << static_cast<double>(candidatesFound) / queriesRun << " per query)";
+  out << '\n';
+}
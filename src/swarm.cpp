@@ -0,0 +1,265 @@
+#include "../include/swarm.h"
+#include "../include/profiler.h"
+#include "../include/settings.h"
+#include "../include/engine.h"
+#include "../include/atlas.h"
+#include "../include/types.h"
+#include "../include/collide.h"
+#include "../include/effects.h"
+#include "../include/random.h"
+#include "../include/jobs.h"
+#include <algorithm>
+#include <cmath>
+#include <cassert>
+#include <string>
+#include <SDL2/SDL.h>
+
+// Static alien texture
+TextureHandle alienTextureSheet;     // Texture sheet to share for all aliens
+std::string alienSheetPath = "graphics/ufos.bmp";
+std::string alienTransparency = "#000000";
+SDL_Rect alienSheetSize = { 0, 0, 0, 0 };  // Dimensions of the alien sheet, filled in by AlienSwarm::init()
+
+extern int playerLives;
+extern World* world;
+
+//Initialize static alien textures before we can build the swarm
+bool AlienSwarm::init(){
+  // Headless runs have no renderer, aliens take their size from the sheet header
+  if(settings::headless) {
+    if(!SDL::readImageSize(alienSheetPath, alienSheetSize.w, alienSheetSize.h))
+      return false;
+    SDL::alien_init = true;
+    return true;
+  }
+
+  // Use the packed copy of the sheet if there is one
+  RGB color = hexToRGB(alienTransparency);
+  Atlas::Region region;
+  if(Atlas::find(alienSheetPath, color, region)) {
+    alienTextureSheet = region.texture;
+    alienSheetSize = region.rect;
+    SDL::alien_init = true;
+    return true;
+  }
+
+  //Initialize the static alien texture
+  alienTextureSheet = Resources::load(alienSheetPath, color);
+  if(!alienTextureSheet) {
+    std::cout << "Failed to intitialize static alien texture!\n";
+    return false;
+  }
+  SDL::FillRect(alienSheetSize, 0, 0, alienTextureSheet.getWidth(), alienTextureSheet.getHeight());
+
+  SDL::alien_init = true;  // Mark static initialization as completed
+  return true;
+}
+
+// The classic 4x10 wave just spans the window between its gutters and fills a third of its height
+// Bigger waves get a field the window's shape, wide enough for the wave and twice its height, so it has as far to march
+void AlienSwarm::fitField() {
+  const long long alienWidth = alienSheetSize.w / MAX_SPRITE_FRAME;
+  const long long alienHeight = alienSheetSize.h / int(Color::MAX_COLORS);
+  const long long wide = 2LL * settings::swarmGutter + settings::swarmColumns * (alienWidth + settings::swarmGap) - settings::swarmGap;
+  const long long tall = 2 * (settings::swarmRows * (alienHeight + settings::swarmGap) + settings::swarmGap);
+  // Scale both sides by the same amount so the field is never squashed on screen
+  const double scale = std::max({ 1.0, static_cast<double>(wide) / settings::SCREEN_WIDTH, static_cast<double>(tall) / settings::SCREEN_HEIGHT });
+  settings::fieldWidth = static_cast<int>(std::ceil(settings::SCREEN_WIDTH * scale));
+  settings::fieldHeight = static_cast<int>(std::ceil(settings::SCREEN_HEIGHT * scale));
+}
+
+// Create the swarm and set the initial location of every alien
+AlienSwarm::AlienSwarm(int rowCount, int columnCount, int speed)
+  : rows{ rowCount }, columns{ columnCount }, count{ rowCount * columnCount }, speed{ speed },
+    xPos(count), yPos(count), xPrev(count), yPrev(count),
+    colors(count), frames(count), frameCounters(count), frameDelays(count), alive(count),
+    hitMask(Collide::maskWords(count)),
+    rowVelocity(rowCount), lowestAlive(columnCount)
+{
+  // Ensure static members have been initialized before constructing the swarm
+  assert((SDL::alien_init == true) && "Fatal Error: Tried to create alien swarm before initializing static members.");
+
+  width = alienSheetSize.w / MAX_SPRITE_FRAME;   // Get the width of a single sprite
+  height = alienSheetSize.h / int(Color::MAX_COLORS);  // Get the height of a single sprite
+
+  for(int i = 0; i < count; ++i) {
+    frameDelays[i] = gameRandom.below(50) + 30;  // Set animation speed to a random value
+  }
+  resetRound(speed);
+}
+
+// Set initial position for each alien
+void AlienSwarm::resetLocation() {
+  for(int row = 0; row < rows; ++row) {
+    int xLoc = settings::swarmGutter;
+    int yLoc = ((height + settings::swarmGap) * row) + settings::swarmGap;
+    for(int i = row * columns; i < (row + 1) * columns; ++i) {
+      xPos[i] = xPrev[i] = xLoc;
+      yPos[i] = yPrev[i] = yLoc;
+      xLoc += width + settings::swarmGap;
+    }
+    //Set the direction
+    if(row % 2 == 0)  // If we have an even row move right
+      rowVelocity[row] = speed * static_cast<int>(Direction::right);
+    else
+      rowVelocity[row] = speed * static_cast<int>(Direction::left);
+  }
+}
+
+// Bring every alien back to life for the given round
+void AlienSwarm::resetRound(int round) {
+  speed = settings::stretch(settings::swarmSpeed * round);  // Crosses a stretched field as fast as the window
+  resetLocation();
+  alive.fill();
+  remaining = alive.count();
+  for(int column = 0; column < columns; ++column)
+    lowestAlive[column] = rows - 1;
+  for(int i = 0; i < count; ++i) {
+    //Randomize color and starting frame
+    colors[i] = gameRandom.below(int(Color::MAX_COLORS));
+    frames[i] = gameRandom.below(MAX_SPRITE_FRAME);
+    frameCounters[i] = 0;
+  }
+}
+
+// Mark an alien as destroyed
+// If it was the bottom of its column, walk up the column to the next living alien
+void AlienSwarm::destroy(int index) {
+  if(alive.test(index)) {
+    alive.reset(index);
+    remaining--;
+    const int column = index % columns;
+    if(lowestAlive[column] == index / columns) {
+      int row = lowestAlive[column] - 1;
+      while(row >= 0 && !alive.test(row * columns + column))
+        row--;
+      lowestAlive[column] = row;
+    }
+  }
+}
+
+// Advance animations and move each row, bouncing off the screen edges
+// Only living aliens are animated, but whole rows move so the formation keeps its shape
+// Aliens and rows don't affect each other, so big swarms are split into chunks across threads
+void AlienSwarm::update(){
+  PROFILE_SCOPE("AlienSwarm::update");
+  // Animate every living alien, a chunk at a time
+  Jobs::parallelFor(count, ALIEN_GRAIN, [this](int, int first, int last) {
+    alive.forEach(first, last, [this](int i) {
+      frameCounters[i]++;
+      if(frameCounters[i] > frameDelays[i]) {   // If we reached the delay time
+        frameCounters[i] = 0;
+        frames[i] = (frames[i] + 1) % MAX_SPRITE_FRAME;  // Advance, wrapping to the first frame
+      }
+    });
+  });
+
+  // Move whole rows, as many to a chunk as make up about ALIEN_GRAIN aliens
+  Jobs::parallelFor(rows, std::max(ALIEN_GRAIN / columns, 1), [this](int, int first, int last) {
+    moveRows(first, last);
+  });
+}
+
+// Move each row in [firstRow, lastRow) as a unit
+void AlienSwarm::moveRows(int firstRow, int lastRow) {
+  PROFILE_SCOPE("AlienSwarm::moveRows");
+  std::copy(xPos.begin() + firstRow * columns, xPos.begin() + lastRow * columns, xPrev.begin() + firstRow * columns);
+  std::copy(yPos.begin() + firstRow * columns, yPos.begin() + lastRow * columns, yPrev.begin() + firstRow * columns);
+  const int maxX = settings::fieldWidth - width;
+  const int drop = settings::stretch(height + settings::swarmGap);  // Rows step down the same share of the field
+  for(int row = firstRow; row < lastRow; ++row) {
+    const int first = row * columns;
+    const int last = first + columns;
+    const int velocity = rowVelocity[row];
+    bool hitWall = false;
+    for(int i = first; i < last; ++i) {
+      int x = xPos[i] + velocity;
+      if(x <= 0) {    // Stop at the left edge
+        x = 0;
+        hitWall = true;
+      }
+      else if(x >= maxX) {  // Stop at the right edge
+        x = maxX;
+        hitWall = true;
+      }
+      xPos[i] = x;
+    }
+    if(hitWall) { // If we collide with a wall flip direction and move the row down
+      rowVelocity[row] = -velocity;
+      for(int i = first; i < last; ++i)
+        yPos[i] += drop;
+    }
+  }
+}
+
+// Draw each living alien to the render, interpolated alpha of the way from the previous tick
+// Every alien shares one sheet, so the whole swarm replays as a single batch
+void AlienSwarm::draw(Render::Frame& frame, float alpha){
+  PROFILE_SCOPE("AlienSwarm::draw");
+  SDL_Rect source = { 0, 0, width, height };
+  SDL_Rect placement = { 0, 0, width, height };
+  SDL_Texture* texture = alienTextureSheet.get();
+  alive.forEach([&](int i) {
+    source.x = alienSheetSize.x + frames[i] * width;   // Offset into the sheet's spot in the atlas
+    source.y = alienSheetSize.y + colors[i] * height;
+    placement.x = xPrev[i] + static_cast<int>((xPos[i] - xPrev[i]) * alpha);
+    placement.y = yPrev[i] + static_cast<int>((yPos[i] - yPrev[i]) * alpha);
+    frame.add(Layer::aliens, texture, source, placement);
+  });
+}
+
+// Check if any living alien hits the player or reaches the player base
+bool AlienSwarm::checkCollisions(const SDL_Rect& playerBox){
+  PROFILE_SCOPE("AlienSwarm::checkCollisions");
+  if(isEmpty())
+    return false;
+
+  const int baseLine = settings::stretch(BASE_LINE) - height;  // Aliens at or below this have reached the base
+  bool hitPlayer = false;
+  if(Collide::overlaps(playerBox, xPos.data(), yPos.data(), width, height, count, hitMask.data())) {
+    for(int w = 0; w < alive.words() && !hitPlayer; ++w)
+      hitPlayer = (hitMask[w] & alive.word(w)) != 0;  // Only living aliens count
+  }
+  // Lower rows never sit above higher ones, so only the bottom alien in each column can reach the base
+  bool reachedBase = false;
+  for(int column = 0; column < columns && !hitPlayer && !reachedBase; ++column) {
+    const int row = lowestAlive[column];
+    reachedBase = row >= 0 && yPos[row * columns + column] >= baseLine;
+  }
+  if(hitPlayer || reachedBase) {
+    playerLives--;    // Decrement player life
+    // A short chain of blasts over the player
+    const Point2d center = { playerBox.x + playerBox.w / 2, playerBox.y + playerBox.h / 2 };
+    Effects::spawn(*world, EffectType::playerHit, center);
+    Effects::spawn(*world, EffectType::explosion, { center.x - 40, center.y - 20 }, 8);
+    Effects::spawn(*world, EffectType::explosion, { center.x + 40, center.y - 20 }, 16);
+    return true;
+  }
+  return false;
+}
+
+// Hash everything that decides how the swarm plays
+std::uint32_t AlienSwarm::checksum(std::uint32_t hash) const {
+  hash = hashBytes(xPos.data(), count * sizeof(int), hash);
+  hash = hashBytes(yPos.data(), count * sizeof(int), hash);
+  hash = hashBytes(alive.data(), alive.words() * sizeof(std::uint64_t), hash);
+  hash = hashBytes(colors.data(), count, hash);
+  hash = hashBytes(frames.data(), count, hash);
+  hash = hashBytes(rowVelocity.data(), rows * sizeof(int), hash);
+  return hash;
+}
+
+// Print the swarm
+std::ostream& operator<<(std::ostream& out, const AlienSwarm& swarm) {
+  static const char* colorNames[] = { "blue", "brown", "gray", "green", "orange", "pink", "purple", "red", "yellow" };
+
+  out << "Alien Swarm [" << swarm.rows << " x " << swarm.columns << "], " << swarm.remaining << " remaining\n";
+  for(int i = 0; i < swarm.count; ++i) {
+    out << "*Alien " << i << ": " << Point2d{ swarm.xPos[i], swarm.yPos[i] }
+        << " UFO Color: " << colorNames[swarm.colors[i]] << '(' << static_cast<int>(swarm.colors[i]) << ')'
+        << " Frame: " << swarm.frames[i] + 1 << " / " << AlienSwarm::MAX_SPRITE_FRAME
+        << (swarm.alive.test(i) ? "" : " [destroyed]") << '\n';
+  }
+
+  return out;
+}
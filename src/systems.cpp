@@ -0,0 +1,78 @@
+#include "../include/systems.h"
+#include "../include/profiler.h"
+#include <vector>
+#include <SDL2/SDL.h>
+
+namespace {
+  std::vector<Entity> expired;  // Entities to destroy once the lifetime pass is done
+}
+
+namespace Systems {
+  void snapshot(World& world) {
+    PROFILE_SCOPE("Systems::snapshot");
+    world.each<Transform>([](Transform& transform) {
+      transform.previous = transform.position;
+    });
+  }
+
+  // Hold each frame for frameDelay ticks, then wrap back to the first frame at the end of the strip
+  void animate(World& world) {
+    PROFILE_SCOPE("Systems::animate");
+    world.each<Animation, Sprite>([](Animation& animation, Sprite& sprite) {
+      animation.counter++;
+      if(animation.counter > animation.frameDelay) {  // If we reached the delay time
+        animation.counter = 0;
+        sprite.frame++;
+      }
+      if(sprite.frame > animation.frames - 1)   // If we've reached the last frame
+        sprite.frame = 0;
+    });
+  }
+
+  void age(World& world) {
+    PROFILE_SCOPE("Systems::age");
+    expired.clear();
+    world.each<Lifetime>([](Entity entity, Lifetime& lifetime) {
+      if(lifetime.delay > 0)
+        lifetime.delay--;
+      else if(--lifetime.ticks <= 0)
+        expired.push_back(entity);
+    });
+    world.each<Lifetime, Sprite>([](Lifetime& lifetime, Sprite& sprite) {
+      sprite.visible = (lifetime.delay == 0);   // Stay hidden until the delay is over
+    });
+    for(Entity entity : expired)
+      world.destroy(entity);
+  }
+
+  // Sprites are added in archetype order, the replay starts a new batch whenever the texture changes
+  // With the atlas every sheet shares a texture, so a layer is usually a single draw call
+  void render(World& world, Render::Frame& frame, Layer layer, float alpha) {
+    PROFILE_SCOPE("Systems::render");
+    world.each<Transform, Sprite>([&](Transform& transform, Sprite& sprite) {
+      if(!sprite.visible || sprite.layer != layer)
+        return;
+      SDL_Rect source = sprite.source;
+      source.x += sprite.frame * sprite.source.w;
+      const SDL_Rect placement = {
+        transform.previous.x + static_cast<int>((transform.position.x - transform.previous.x) * alpha),
+        transform.previous.y + static_cast<int>((transform.position.y - transform.previous.y) * alpha),
+        sprite.source.w, sprite.source.h
+      };
+      frame.add(layer, sprite.texture, source, placement);
+    });
+  }
+
+  void snap(World& world, Entity entity) {
+    if(Transform* transform = world.get<Transform>(entity))
+      transform->previous = transform->position;
+  }
+
+  SDL_Rect bounds(World& world, Entity entity) {
+    const Transform* transform = world.get<Transform>(entity);
+    const Collider* collider = world.get<Collider>(entity);
+    if(transform == NULL || collider == NULL)
+      return { 0, 0, 0, 0 };
+    return { transform->position.x, transform->position.y, collider->width, collider->height };
+  }
+}
@@ -0,0 +1,43 @@
+#include "../include/timestep.h"
+#include <SDL2/SDL.h>
+
+// Create a timestep running at the given number of ticks per second
+FixedTimestep::FixedTimestep(int tickRate)
+  : frequency{ SDL_GetPerformanceFrequency() }
+{
+  stepLength = frequency / static_cast<Uint64>(tickRate);
+  reset();
+}
+
+void FixedTimestep::reset() {
+  previous = SDL_GetPerformanceCounter();
+  accumulator = 0;
+}
+
+void FixedTimestep::advance() {
+  Uint64 now = SDL_GetPerformanceCounter();
+  accumulator += now - previous;
+  previous = now;
+
+  // If we fell too far behind, drop the excess rather than spiral trying to catch up
+  if(accumulator > stepLength * MAX_STEPS)
+    accumulator = stepLength * MAX_STEPS;
+}
+
+bool FixedTimestep::step() {
+  if(accumulator < stepLength)
+    return false;   // Not enough time has built up for another tick
+  accumulator -= stepLength;
+  return true;
+}
+
+float FixedTimestep::alpha() const {
+  return static_cast<float>(accumulator) / static_cast<float>(stepLength);
+}
+
+// Measured from the last call to advance()
+int FixedTimestep::msToStep() const {
+  if(accumulator >= stepLength)
+    return 0;
+  return static_cast<int>(((stepLength - accumulator) * 1000 + frequency - 1) / frequency);
+}
@@ -48,3 +48,13 @@ const RGB hexToRGB(const std::string hex) {
     static_cast<std::uint8_t>(std::stoi(hexColor.substr(4, 2), nullptr, 16))
   };
 }
+
+// Hash a block of memory a byte at a time
+std::uint32_t hashBytes(const void* data, std::size_t bytes, std::uint32_t hash) {
+  const unsigned char* byte = static_cast<const unsigned char*>(data);
+  for(std::size_t i = 0; i < bytes; ++i) {
+    hash ^= byte[i];
+    hash *= 16777619u;
+  }
+  return hash;
+}
@@ -0,0 +1,347 @@
+// Cook the game's bitmaps and data files into one packed asset archive (.pak)
+// Usage: assetcook <manifest> <output.pak>
+#include "../include/assetformat.h"
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <iterator>
+#include <algorithm>
+
+const int MAX_PAGE_SIZE = 2048;   // Largest atlas page, the smallest texture limit the game supports
+const int PADDING = 1;    // Gap left between packed sheets
+
+// One line of the manifest
+struct Asset {
+  std::string kind;   // image, sheet or blob
+  std::string path;
+  std::uint32_t transparency = assetformat::NO_TRANSPARENCY;
+  int frames = 1;
+  int frameDelay = 0;
+};
+
+// Decoded image, ARGB8888 top row first
+struct Image {
+  int width = 0;
+  int height = 0;
+  std::vector<std::uint32_t> pixels;
+};
+
+static bool readFile(const std::string& path, std::vector<unsigned char>& bytes) {
+  std::ifstream in(path, std::ios::binary);
+  if(!in.good())
+    return false;
+  bytes.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+  return true;
+}
+
+// Read a little-endian value
+static std::uint32_t readLE(const std::vector<unsigned char>& bytes, size_t offset, int count) {
+  std::uint32_t value = 0;
+  for(int i = count - 1; i >= 0; --i)
+    value = (value << 8) | bytes[offset + i];
+  return value;
+}
+
+// Uncompressed 8, 24 and 32-bit bitmaps, with the color key turned into fully transparent pixels
+// Paletted images key on the palette entry nearest the color, the same one SDL's color key picks
+static bool readBitmap(const std::string& path, std::uint32_t transparency, Image& image) {
+  std::vector<unsigned char> bytes;
+  if(!readFile(path, bytes) || bytes.size() < 54 || bytes[0] != 'B' || bytes[1] != 'M') {
+    std::cout << "Unable to read bitmap: " << path << '\n';
+    return false;
+  }
+  const std::uint32_t dataOffset = readLE(bytes, 10, 4);
+  const std::uint32_t headerSize = readLE(bytes, 14, 4);
+  const std::int32_t width = static_cast<std::int32_t>(readLE(bytes, 18, 4));
+  const std::int32_t height = static_cast<std::int32_t>(readLE(bytes, 22, 4));
+  const int bitsPerPixel = static_cast<int>(readLE(bytes, 28, 2));
+  const std::uint32_t compression = readLE(bytes, 30, 4);
+  if(headerSize < 40 || compression != 0 || (bitsPerPixel != 8 && bitsPerPixel != 24 && bitsPerPixel != 32) || width <= 0 || height == 0) {
+    std::cout << "Only uncompressed 8, 24 and 32-bit bitmaps are supported: " << path << '\n';
+    return false;
+  }
+  image.width = width;
+  image.height = std::abs(height);
+  const bool topDown = height < 0;
+  const size_t rowBytes = (static_cast<size_t>(width) * bitsPerPixel / 8 + 3) & ~static_cast<size_t>(3);  // Rows pad to 4 bytes
+  if(dataOffset + rowBytes * image.height > bytes.size()) {
+    std::cout << "Bitmap is truncated: " << path << '\n';
+    return false;
+  }
+
+  // Palette entries are stored blue, green, red, unused
+  std::vector<std::uint32_t> palette;
+  int keyIndex = -1;
+  if(bitsPerPixel == 8) {
+    std::uint32_t colors = readLE(bytes, 46, 4);
+    if(colors == 0 || colors > 256)
+      colors = 256;
+    const size_t paletteOffset = 14 + headerSize;
+    if(paletteOffset + colors * 4 > dataOffset) {
+      std::cout << "Bitmap palette is truncated: " << path << '\n';
+      return false;
+    }
+    int nearest = 3 * 255 * 255 + 1;
+    for(std::uint32_t i = 0; i < colors; ++i) {
+      const unsigned char* entry = &bytes[paletteOffset + i * 4];
+      palette.push_back((entry[2] << 16) | (entry[1] << 8) | entry[0]);
+      if(transparency == assetformat::NO_TRANSPARENCY)
+        continue;
+      const int dr = entry[2] - static_cast<int>((transparency >> 16) & 0xff);
+      const int dg = entry[1] - static_cast<int>((transparency >> 8) & 0xff);
+      const int db = entry[0] - static_cast<int>(transparency & 0xff);
+      const int distance = dr * dr + dg * dg + db * db;
+      if(distance < nearest) {
+        nearest = distance;
+        keyIndex = static_cast<int>(i);
+      }
+    }
+  }
+
+  image.pixels.resize(static_cast<size_t>(image.width) * image.height);
+  for(int row = 0; row < image.height; ++row) {
+    const unsigned char* source = &bytes[dataOffset + rowBytes * (topDown ? row : image.height - 1 - row)];
+    std::uint32_t* destination = &image.pixels[static_cast<size_t>(row) * image.width];
+    for(int x = 0; x < image.width; ++x) {
+      std::uint32_t color = 0;
+      bool keyed = false;
+      if(bitsPerPixel == 8) {
+        const int index = source[x];
+        color = (index < static_cast<int>(palette.size())) ? palette[index] : 0;
+        keyed = (index == keyIndex);
+      }
+      else {
+        const unsigned char* pixel = source + x * (bitsPerPixel / 8);
+        color = (pixel[2] << 16) | (pixel[1] << 8) | pixel[0];
+        keyed = (color == transparency);
+      }
+      destination[x] = keyed ? 0 : (0xff000000 | color);
+    }
+  }
+  return true;
+}
+
+// '#rrggbb' or '-' for no color key
+static bool parseColor(const std::string& text, std::uint32_t& color) {
+  if(text == "-") {
+    color = assetformat::NO_TRANSPARENCY;
+    return true;
+  }
+  if(text.size() != 7 || text[0] != '#' || text.find_first_not_of("0123456789abcdefABCDEF", 1) != std::string::npos)
+    return false;
+  color = static_cast<std::uint32_t>(std::strtoul(text.c_str() + 1, NULL, 16));
+  return true;
+}
+
+// One asset per line, blank lines and lines starting with '#' are skipped:
+//   image <path> <color key or ->
+//   sheet <path> <color key> <frames> <frame delay>
+//   blob <path>
+static bool readManifest(const std::string& path, std::vector<Asset>& assets) {
+  std::ifstream in(path);
+  if(!in.good()) {
+    std::cout << "Unable to read manifest: " << path << '\n';
+    return false;
+  }
+  std::string line;
+  int lineNumber = 0;
+  while(std::getline(in, line)) {
+    lineNumber++;
+    std::stringstream fields(line);
+    Asset asset;
+    if(!(fields >> asset.kind) || asset.kind[0] == '#')
+      continue;
+    std::string color;
+    bool valid = false;
+    if(asset.kind == "image")
+      valid = (fields >> asset.path >> color) && parseColor(color, asset.transparency);
+    else if(asset.kind == "sheet")
+      valid = (fields >> asset.path >> color >> asset.frames >> asset.frameDelay) && parseColor(color, asset.transparency) && asset.frames > 0 && asset.frameDelay >= 0;
+    else if(asset.kind == "blob")
+      valid = static_cast<bool>(fields >> asset.path);
+    if(!valid || asset.path.size() >= sizeof(assetformat::Entry::name)) {
+      std::cout << path << ':' << lineNumber << ": can't read asset line\n";
+      return false;
+    }
+    assets.push_back(asset);
+  }
+  return true;
+}
+
+// Shelf pack the sheets tallest first, the same way the game packs its atlas when there is no archive
+// Returns the number of pages used, or 0 if a sheet can't fit on any page
+static int pack(const std::vector<Image>& sheets, std::vector<int>& pages, std::vector<int>& xs, std::vector<int>& ys) {
+  std::vector<size_t> order(sheets.size());
+  for(size_t i = 0; i < order.size(); ++i)
+    order[i] = i;
+  std::sort(order.begin(), order.end(), [&sheets](size_t a, size_t b) { return sheets[a].height > sheets[b].height; });
+
+  pages.assign(sheets.size(), 0);
+  xs.assign(sheets.size(), 0);
+  ys.assign(sheets.size(), 0);
+  int page = 0;
+  int x = 0;
+  int y = 0;
+  int shelfHeight = 0;
+  for(size_t i : order) {
+    const Image& sheet = sheets[i];
+    if(sheet.width > MAX_PAGE_SIZE || sheet.height > MAX_PAGE_SIZE)
+      return 0;
+    if(x + sheet.width > MAX_PAGE_SIZE) {
+      y += shelfHeight + PADDING;
+      x = 0;
+      shelfHeight = 0;
+    }
+    if(y + sheet.height > MAX_PAGE_SIZE) {
+      page++;
+      x = 0;
+      y = 0;
+      shelfHeight = 0;
+    }
+    pages[i] = page;
+    xs[i] = x;
+    ys[i] = y;
+    x += sheet.width + PADDING;
+    shelfHeight = std::max(shelfHeight, sheet.height);
+  }
+  return sheets.empty() ? 0 : page + 1;
+}
+
+// Append data to the archive on an aligned offset and point the entry at it
+static void appendData(std::vector<unsigned char>& archive, assetformat::Entry& entry, const void* data, size_t size) {
+  archive.resize((archive.size() + assetformat::DATA_ALIGNMENT - 1) & ~static_cast<size_t>(assetformat::DATA_ALIGNMENT - 1));
+  entry.offset = static_cast<std::uint32_t>(archive.size());
+  entry.size = static_cast<std::uint32_t>(size);
+  const unsigned char* bytes = static_cast<const unsigned char*>(data);
+  archive.insert(archive.end(), bytes, bytes + size);
+}
+
+static assetformat::Entry makeEntry(const std::string& name, std::uint16_t kind) {
+  assetformat::Entry entry;
+  std::memset(&entry, 0, sizeof(entry));
+  std::memcpy(entry.name, name.c_str(), name.size());
+  entry.kind = kind;
+  entry.frames = 1;
+  entry.transparency = assetformat::NO_TRANSPARENCY;
+  return entry;
+}
+
+static void appendImage(std::vector<unsigned char>& archive, assetformat::Entry& entry, const Image& image) {
+  entry.width = static_cast<std::uint16_t>(image.width);
+  entry.height = static_cast<std::uint16_t>(image.height);
+  entry.pitch = static_cast<std::uint32_t>(image.width) * 4;
+  appendData(archive, entry, image.pixels.data(), image.pixels.size() * 4);
+}
+
+int main(int argc, char* argv[]) {
+  if(argc < 3) {
+    std::cout << "Usage: assetcook <manifest> <output.pak>\n";
+    return 1;
+  }
+  std::vector<Asset> assets;
+  if(!readManifest(argv[1], assets))
+    return 1;
+
+  std::vector<unsigned char> archive(sizeof(assetformat::Header));
+  std::vector<assetformat::Entry> entries;
+  std::vector<Image> sheets;
+  std::vector<size_t> sheetEntries;   // Index of each sheet's entry
+  for(const Asset& asset : assets) {
+    if(asset.kind == "blob") {
+      std::vector<unsigned char> bytes;
+      if(!readFile(asset.path, bytes) || bytes.empty()) {
+        std::cout << "Unable to read file: " << asset.path << '\n';
+        return 1;
+      }
+      entries.push_back(makeEntry(asset.path, assetformat::BLOB));
+      appendData(archive, entries.back(), bytes.data(), bytes.size());
+      continue;
+    }
+
+    Image image;
+    if(!readBitmap(asset.path, asset.transparency, image))
+      return 1;
+    if(image.width > 0xffff || image.height > 0xffff) {
+      std::cout << "Bitmap is too large: " << asset.path << '\n';
+      return 1;
+    }
+    entries.push_back(makeEntry(asset.path, asset.kind == "image" ? assetformat::IMAGE : assetformat::SHEET));
+    assetformat::Entry& entry = entries.back();
+    entry.transparency = asset.transparency;
+    entry.frames = static_cast<std::uint16_t>(asset.frames);
+    entry.frameDelay = static_cast<std::uint16_t>(asset.frameDelay);
+    if(asset.kind == "image") {
+      appendImage(archive, entry, image);
+    }
+    else {
+      entry.width = static_cast<std::uint16_t>(image.width);
+      entry.height = static_cast<std::uint16_t>(image.height);
+      sheetEntries.push_back(entries.size() - 1);
+      sheets.push_back(std::move(image));
+    }
+  }
+
+  // Pack the sheets onto atlas pages, each page only as big as the sheets on it need
+  std::vector<int> sheetPages;
+  std::vector<int> xs;
+  std::vector<int> ys;
+  const int pageCount = pack(sheets, sheetPages, xs, ys);
+  if(!sheets.empty() && pageCount == 0) {
+    std::cout << "Sheets are too large to fit in an atlas page\n";
+    return 1;
+  }
+  for(int page = 0; page < pageCount; ++page) {
+    Image pageImage;
+    for(size_t i = 0; i < sheets.size(); ++i) {
+      if(sheetPages[i] == page) {
+        pageImage.width = std::max(pageImage.width, xs[i] + sheets[i].width);
+        pageImage.height = std::max(pageImage.height, ys[i] + sheets[i].height);
+      }
+    }
+    pageImage.pixels.assign(static_cast<size_t>(pageImage.width) * pageImage.height, 0);
+    for(size_t i = 0; i < sheets.size(); ++i) {
+      if(sheetPages[i] != page)
+        continue;
+      for(int row = 0; row < sheets[i].height; ++row)
+        std::copy_n(&sheets[i].pixels[static_cast<size_t>(row) * sheets[i].width], sheets[i].width,
+                    &pageImage.pixels[static_cast<size_t>(ys[i] + row) * pageImage.width + xs[i]]);
+      assetformat::Entry& sheetEntry = entries[sheetEntries[i]];
+      sheetEntry.page = static_cast<std::uint16_t>(entries.size());
+      sheetEntry.x = static_cast<std::uint16_t>(xs[i]);
+      sheetEntry.y = static_cast<std::uint16_t>(ys[i]);
+    }
+    entries.push_back(makeEntry("atlas:page" + std::to_string(page), assetformat::IMAGE));
+    appendImage(archive, entries.back(), pageImage);
+  }
+
+  // Index at the end, then the header at the front now everything's place is known
+  if(entries.size() > 0xffff) {
+    std::cout << "Too many assets for one archive\n";
+    return 1;
+  }
+  assetformat::Entry index;
+  appendData(archive, index, entries.data(), entries.size() * sizeof(assetformat::Entry));
+  assetformat::Header header;
+  std::memcpy(header.magic, assetformat::MAGIC, sizeof(header.magic));
+  header.version = assetformat::VERSION;
+  header.entryCount = static_cast<std::uint16_t>(entries.size());
+  header.pixelFormat = assetformat::PIXEL_FORMAT;
+  header.indexOffset = index.offset;
+  std::memcpy(archive.data(), &header, sizeof(header));
+
+  std::ofstream out(argv[2], std::ios::binary);
+  out.write(reinterpret_cast<const char*>(archive.data()), static_cast<std::streamsize>(archive.size()));
+  if(!out.good()) {
+    std::cout << "Unable to write archive: " << argv[2] << '\n';
+    return 1;
+  }
+
+  std::cout << "Wrote " << argv[2] << ": " << entries.size() << " entries, " << sheets.size() << " sheets on "
+            << pageCount << " atlas page(s), " << archive.size() / 1024 << "KB\n";
+  return 0;
+}
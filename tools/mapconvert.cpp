@@ -0,0 +1,180 @@
+// Convert text tilemaps (.map) and Tiled maps (.tmx) to the binary .tmb format
+// Usage: mapconvert <input.map|input.tmx> <output.tmb> [sheet id]
+#include "../include/mapformat.h"
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <algorithm>
+
+// Map data read from either source format
+struct MapData {
+  int columns = 0;
+  int rows = 0;
+  int tileWidth = 0;
+  int tileHeight = 0;
+  std::vector<std::vector<int>> layers;   // Tile ids per layer, row by row
+};
+
+// Pull every integer out of a comma separated block
+static std::vector<int> parseCSV(const std::string& text) {
+  std::vector<int> values;
+  std::string cell;
+  std::stringstream stream(text);
+  while(std::getline(stream, cell, ',')) {
+    if(cell.find_first_of("0123456789") != std::string::npos)
+      values.push_back(std::atoi(cell.c_str()));
+  }
+  return values;
+}
+
+// Text format: 'key value' header lines, then a 'layer' line before each block of rows
+static bool readText(const std::string& path, MapData& map) {
+  std::ifstream in(path);
+  if(!in.good())
+    return false;
+
+  std::string line;
+  std::string block;
+  bool inLayer = false;
+  while(std::getline(in, line)) {
+    std::stringstream fields(line);
+    std::string key;
+    fields >> key;
+    if(key == "mapWidth")
+      fields >> map.columns;
+    else if(key == "mapHeight")
+      fields >> map.rows;
+    else if(key == "tile_width")
+      fields >> map.tileWidth;
+    else if(key == "tile_height")
+      fields >> map.tileHeight;
+    else if(key.rfind("layer", 0) == 0) {   // Start of a new layer
+      if(inLayer)
+        map.layers.push_back(parseCSV(block));
+      block.clear();
+      inLayer = true;
+    }
+    else if(inLayer)
+      block += line + ',';
+  }
+  if(inLayer)
+    map.layers.push_back(parseCSV(block));
+  return true;
+}
+
+// Read a quoted attribute value out of an XML tag
+static int attribute(const std::string& tag, const std::string& name) {
+  std::string pattern = ' ' + name + "=\"";
+  size_t start = tag.find(pattern);
+  if(start == std::string::npos)
+    return 0;
+  return std::atoi(tag.c_str() + start + pattern.size());
+}
+
+// Tiled format: map attributes on the <map> tag, one csv <data> block per <layer>
+static bool readTMX(const std::string& path, MapData& map) {
+  std::ifstream in(path);
+  if(!in.good())
+    return false;
+  std::stringstream contents;
+  contents << in.rdbuf();
+  std::string xml = contents.str();
+
+  size_t mapTag = xml.find("<map ");
+  if(mapTag == std::string::npos)
+    return false;
+  std::string tag = xml.substr(mapTag, xml.find('>', mapTag) - mapTag);
+  map.columns = attribute(tag, "width");
+  map.rows = attribute(tag, "height");
+  map.tileWidth = attribute(tag, "tilewidth");
+  map.tileHeight = attribute(tag, "tileheight");
+
+  size_t position = 0;
+  while((position = xml.find("<data", position)) != std::string::npos) {
+    if(xml.find("encoding=\"csv\"", position) > xml.find('>', position)) {
+      std::cout << "Only csv encoded layers are supported\n";
+      return false;
+    }
+    size_t start = xml.find('>', position) + 1;
+    size_t end = xml.find("</data>", start);
+    map.layers.push_back(parseCSV(xml.substr(start, end - start)));
+    position = end;
+  }
+  return true;
+}
+
+static bool endsWith(const std::string& text, const std::string& suffix) {
+  return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+int main(int argc, char* argv[]) {
+  if(argc < 3) {
+    std::cout << "Usage: mapconvert <input.map|input.tmx> <output.tmb> [sheet id]\n";
+    return 1;
+  }
+  std::string input = argv[1];
+  std::string output = argv[2];
+  int sheetId = (argc > 3) ? std::atoi(argv[3]) : 0;
+
+  MapData map;
+  bool read = endsWith(input, ".tmx") ? readTMX(input, map) : readText(input, map);
+  if(!read || map.columns <= 0 || map.rows <= 0 || map.layers.empty()) {
+    std::cout << "Unable to read map: " << input << '\n';
+    return 1;
+  }
+  if(sheetId < 0 || sheetId >= mapformat::SHEET_COUNT) {
+    std::cout << "Unknown sheet id: " << sheetId << '\n';
+    return 1;
+  }
+
+  // Check every layer is complete and find the widest tile id
+  const size_t tileCount = static_cast<size_t>(map.columns) * map.rows;
+  int maxTile = 0;
+  for(const std::vector<int>& layer : map.layers) {
+    if(layer.size() != tileCount) {
+      std::cout << "Layer has " << layer.size() << " tiles, expected " << tileCount << '\n';
+      return 1;
+    }
+    maxTile = std::max(maxTile, *std::max_element(layer.begin(), layer.end()));
+  }
+
+  mapformat::Header header;
+  std::memcpy(header.magic, mapformat::MAGIC, sizeof(header.magic));
+  header.version = mapformat::VERSION;
+  header.bitsPerTile = (maxTile < 256) ? 8 : 16;
+  header.columns = static_cast<std::uint16_t>(map.columns);
+  header.rows = static_cast<std::uint16_t>(map.rows);
+  header.tileWidth = static_cast<std::uint16_t>(map.tileWidth);
+  header.tileHeight = static_cast<std::uint16_t>(map.tileHeight);
+  header.sheetId = static_cast<std::uint16_t>(sheetId);
+  header.layerCount = static_cast<std::uint16_t>(map.layers.size());
+  header.dataOffset = sizeof(mapformat::Header);
+
+  std::ofstream out(output, std::ios::binary);
+  out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  for(const std::vector<int>& layer : map.layers) {
+    for(int tile : layer) {
+      if(header.bitsPerTile == 8) {
+        std::uint8_t packed = static_cast<std::uint8_t>(tile);
+        out.write(reinterpret_cast<const char*>(&packed), 1);
+      }
+      else {
+        std::uint8_t packed[2] = { static_cast<std::uint8_t>(tile & 0xff), static_cast<std::uint8_t>(tile >> 8) };
+        out.write(reinterpret_cast<const char*>(packed), 2);
+      }
+    }
+  }
+  if(!out.good()) {
+    std::cout << "Unable to write map: " << output << '\n';
+    return 1;
+  }
+
+  std::cout << "Wrote " << output << ": " << map.columns << 'x' << map.rows << ", " << map.layers.size()
+            << " layer(s), " << header.bitsPerTile << " bits per tile\n";
+  return 0;
+}